@@ -0,0 +1,827 @@
+// Kernel benchmark tasks
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM (or any board in board.h)
+// System Clock:    40 MHz
+
+// Build rtos.c with RTOS_BENCH to run these instead of the demo tasks.
+// benchA and benchB run at the same priority and meet (post/wait handshake)
+// before every timed loop, so only the loop itself is measured. Every
+// operation is timed on its own with readCycleCounter(), less the cost of
+// reading the counter, and benchA prints a table row per test. With
+// BENCH_CSV each row is followed by a "bench,..." record that
+// tools/benchcmp.py collects and compares between runs.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart0.h"
+#include "uartio.h"
+#include "mm.h"
+#include "kernel.h"
+#include "shell.h"
+#include "board.h"
+#include "ring.h"
+#include "bench.h"
+
+typedef struct _BENCH_STAT
+{
+    uint32_t total;
+    uint32_t min;
+    uint32_t max;
+    uint32_t count;
+} BENCH_STAT;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void clearBenchStat(BENCH_STAT *stat)
+{
+    stat->total = 0;
+    stat->min = 0xFFFFFFFF;
+    stat->max = 0;
+    stat->count = 0;
+}
+
+void addBenchSample(BENCH_STAT *stat, uint32_t cycles)
+{
+    stat->total += cycles;
+    if (cycles < stat->min)
+        stat->min = cycles;
+    if (cycles > stat->max)
+        stat->max = cycles;
+    stat->count++;
+}
+
+// Cost of the two counter reads around an empty operation
+uint32_t getBenchOverhead(void)
+{
+    uint32_t start;
+    uint32_t cycles;
+    uint32_t best = 0xFFFFFFFF;
+    uint8_t i;
+
+    for (i = 0; i < 16; i++)
+    {
+        start = readCycleCounter();
+        cycles = readCycleCounter() - start;
+        if (cycles < best)
+            best = cycles;
+    }
+    return best;
+}
+
+void putsPadded(const char str[], uint8_t width, bool right)
+{
+    uint8_t len = 0;
+
+    while (str[len] != '\0')
+        len++;
+    if (!right)
+        putsUart0((char*)str);
+    for (; len < width; len++)
+        putcUart0(' ');
+    if (right)
+        putsUart0((char*)str);
+}
+
+void printBenchHeader(void)
+{
+    char buf[MAX_CHARS];
+
+    putsUart0("Kernel benchmarks on " BOARD_NAME ", cycles at ");
+    putsUart0(IntToString(BOARD_CLOCK_HZ, buf));
+    putsUart0(" Hz\n");
+    putsPadded(" test", 18, false);
+    putsPadded("avg", 10, true);
+    putsPadded("min", 10, true);
+    putsPadded("max", 10, true);
+    putsPadded("ops", 10, true);
+    putsUart0("\n");
+}
+
+// Prints one table row (and the BENCH_CSV record)
+void printBenchResult(const char name[], BENCH_STAT *stat)
+{
+    char buf[MAX_CHARS];
+    uint32_t avg = stat->count ? stat->total / stat->count : 0;
+
+    if (!stat->count)
+        stat->min = 0;
+
+    putsUart0(" ");
+    putsPadded(name, 17, false);
+    putsPadded(IntToString(avg, buf), 10, true);
+    putsPadded(IntToString(stat->min, buf), 10, true);
+    putsPadded(IntToString(stat->max, buf), 10, true);
+    putsPadded(IntToString(stat->count, buf), 10, true);
+    putsUart0("\n");
+
+#if BENCH_CSV
+    putsUart0("bench," BOARD_NAME ",");
+    putsUart0((char*)name);
+    putsUart0(",");
+    putsUart0(IntToString(avg, buf));
+    putsUart0(",");
+    putsUart0(IntToString(stat->min, buf));
+    putsUart0(",");
+    putsUart0(IntToString(stat->max, buf));
+    putsUart0(",");
+    putsUart0(IntToString(stat->count, buf));
+    putsUart0("\n");
+#endif
+}
+
+// Times mallocFromHeap and freeToHeap, runs privileged before the kernel
+// starts since the allocator tables are not accessible to tasks
+// The blocks go back afterwards, thread-spawn needs the room
+void benchAllocator(void)
+{
+    BENCH_STAT stat;
+    BENCH_STAT freeStat;
+    void *blocks[BENCH_ALLOCS];
+    uint32_t overhead = getBenchOverhead();
+    uint32_t start;
+    uint8_t count;
+    uint8_t i;
+
+    clearBenchStat(&stat);
+    for (count = 0; count < BENCH_ALLOCS; count++)
+    {
+        start = readCycleCounter();
+        blocks[count] = mallocFromHeap(512);
+        if (!blocks[count])
+            break;
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+
+    clearBenchStat(&freeStat);
+    for (i = 0; i < count; i++)
+    {
+        start = readCycleCounter();
+        if (!freeToHeap(blocks[i]))
+            break;
+        addBenchSample(&freeStat, readCycleCounter() - start - overhead);
+    }
+
+    printBenchResult("malloc", &stat);
+    printBenchResult("free", &freeStat);
+}
+
+// Prints messages per second for a stat of cycles per message
+void printBenchRate(const char name[], BENCH_STAT *stat)
+{
+    BENCH_STAT rate;
+    uint32_t avg = stat->count ? stat->total / stat->count : 0;
+
+    clearBenchStat(&rate);
+    if (avg)
+        addBenchSample(&rate, BOARD_CLOCK_HZ / avg);
+    printBenchResult(name, &rate);
+}
+
+// Sets up the benchmark ipc, creates the tasks and runs the allocator test
+bool initBench(void)
+{
+    bool ok;
+
+    ok = initSemaphore(benchPing, 0);
+    ok &= initSemaphore(benchPong, 0);
+    ok &= initMutex(benchMutex);
+    ok &= initEventGroup(benchFlags);
+    ok &= initCondVar(benchCond);
+    ok &= initRwLock(benchRw);
+    ok &= initSemaphore(benchTick, 0);
+    ok &= (createQueue(BENCH_MSG_SIZE, BENCH_QUEUE_DEPTH) == benchQueue);
+    ok &= (createQueue(BLOCK_MESSAGE, BENCH_BLOCKS) == benchBlocks);
+    ok &= (createQueue(BLOCK_MESSAGE, BENCH_BLOCKS) == benchReturns);
+    ok &= initWorkQueue(2, 512);
+    ok &= (createTimer(benchTimerFn, benchTick) == benchTimer);
+    ok &= initBlockPool(BENCH_BLOCKS);
+    ok &= initSemaphore(benchFifo, 0);
+    ok &= initSemaphore(benchPrio, 0);
+    ok &= setSemaphorePriorityOrder(benchPrio, true);
+    ok &= initSemaphore(benchAck, 0);
+    ok &= initSemaphore(benchGateLo, 0);
+    ok &= initSemaphore(benchGateHi, 0);
+    ok &= initSemaphore(benchRingItems, 0);
+    ok &= initSemaphore(benchRingSpace, BENCH_RING_SIZE / BENCH_RING_BATCH);
+    ok &= initSemaphore(benchRingData, 0);
+    ok &= (createPool(2, 3, 512) == benchPool);
+    ok &= createThread(benchA, "BenchA", 4, 1536) != NO_THREAD;
+    ok &= createThread(benchB, "BenchB", 4, 1024) != NO_THREAD;
+    ok &= createThread(benchLo, "BenchLo", 5, 512) != NO_THREAD;
+    ok &= createThread(benchHi, "BenchHi", 3, 512) != NO_THREAD;
+
+    printBenchHeader();
+    if (ok)
+        benchAllocator();
+
+    return ok;
+}
+
+// Waits until the other task reaches the same point
+void benchMeetA(void)
+{
+    post(benchPing);
+    wait(benchPong);
+}
+
+void benchMeetB(void)
+{
+    wait(benchPing);
+    post(benchPong);
+}
+
+// Times sleep(1) from call to return, the spread is the wake-up jitter
+void benchSleep(const char name[], uint32_t overhead)
+{
+    BENCH_STAT stat;
+    uint32_t start;
+    uint32_t i;
+
+    clearBenchStat(&stat);
+    sleep(1);
+    for (i = 0; i < BENCH_SLEEPS; i++)
+    {
+        start = readCycleCounter();
+        sleep(1);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult(name, &stat);
+}
+
+// Queues BenchLo and then BenchHi on a semaphore and times post() to the
+// woken task's ack. Prints the latency and in how many trials BenchHi (the
+// higher priority, later waiter) was woken first, as a 0/1 sample per trial.
+void benchWakeOrder(const char name[], const char winsName[], uint8_t semaphore, uint32_t overhead)
+{
+    BENCH_STAT stat;
+    BENCH_STAT wins;
+    IPCS_SEM_DATA semData;
+    uint32_t start;
+    uint32_t i;
+
+    clearBenchStat(&stat);
+    clearBenchStat(&wins);
+    for (i = 0; i < BENCH_ORDER_ROUNDS; i++)
+    {
+        // BenchLo only runs once benchA blocks, BenchHi as soon as it can
+        post(benchGateLo);
+        sleep(1);
+        post(benchGateHi);
+        yield();
+
+        start = readCycleCounter();
+        post(semaphore);
+        wait(benchAck);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+
+        getSemaphoreInfo(&semData, semaphore);
+        addBenchSample(&wins, stringsEqual(semData.queueNames[0], "BenchLo"));
+
+        post(semaphore);
+        wait(benchAck);
+    }
+    printBenchResult(name, &stat);
+    printBenchResult(winsName, &wins);
+}
+
+// Runs the timed side of every benchmark and prints the results
+// While benchA runs the single task tests benchB is blocked in benchMeetB
+void benchA(void)
+{
+    BENCH_STAT stat;
+    BENCH_STAT waitStat;
+    IPCS_SEM_DATA semData;
+    PS_DATA psData;
+    uint32_t msg[BENCH_MSG_SIZE / 4];
+    uint32_t *block;
+    RING *ring;
+    uint8_t batch[BENCH_RING_BATCH];
+    uint16_t pushed;
+    bool ok;
+    _thread self = getPid("BenchA");
+    _thread peer = getPid("BenchB");
+    uint32_t overhead = getBenchOverhead();
+    uint32_t start;
+    uint32_t i;
+
+    // yield round trip: switches to benchB and back
+    benchMeetA();
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        yield();
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("yield-rt", &stat);
+
+    // semaphore round trip: post wakes benchB, which posts back
+    // the one-way post to wait latency is half of it
+    benchMeetA();
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        post(benchPing);
+        wait(benchPong);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("sem-rt", &stat);
+    stat.total /= 2;
+    stat.min /= 2;
+    stat.max /= 2;
+    printBenchResult("post-wake", &stat);
+
+    // event flag round trip: bit 0 wakes benchB, which answers with bit 1
+    benchMeetA();
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        setFlags(benchFlags, 1);
+        waitFlags(benchFlags, 2, FLAGS_ANY | FLAGS_CLEAR, WAIT_FOREVER);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("flags-rt", &stat);
+
+    // copy queue throughput: benchB drains the queue whenever it fills
+    benchMeetA();
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        msg[0] = i;
+        start = readCycleCounter();
+        sendMessage(benchQueue, msg, WAIT_FOREVER);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("queue-copy", &stat);
+    printBenchRate("queue-copy-msg/s", &stat);
+
+    // zero-copy throughput: BENCH_BLOCKS blocks go to benchB and come back
+    benchMeetA();
+    ok = true;
+    for (i = 0; i < BENCH_BLOCKS; i++)
+    {
+        block = allocBlock();
+        ok &= (block != 0);
+        sendMessage(benchReturns, &block, 0);
+    }
+    clearBenchStat(&stat);
+    for (i = 0; ok && i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        receiveMessage(benchReturns, &block, WAIT_FOREVER);
+        block[0] = i;
+        sendMessage(benchBlocks, &block, WAIT_FOREVER);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    for (i = 0; ok && i < BENCH_BLOCKS; i++)
+    {
+        receiveMessage(benchReturns, &block, WAIT_FOREVER);
+        freeBlock(block);
+    }
+    printBenchResult("queue-zcopy", &stat);
+    printBenchRate("queue-zcopy-msg/s", &stat);
+
+    // ring throughput: benchB gets the ring through a shared block and pops
+    // what is there, waiting only when the ring is empty, benchA yields when
+    // it is full
+    benchMeetA();
+    block = allocBlock();
+    ring = (RING *)block;
+    ok = (block != 0) && initRing(ring, BENCH_RING_SIZE, benchRingItems)
+            && shareBlock(block, peer);
+    msg[0] = ok ? (uint32_t)(uintptr_t)ring : 0;
+    sendMessage(benchQueue, msg, WAIT_FOREVER);
+    for (i = 0; i < BENCH_RING_BATCH; i++)
+        batch[i] = i;
+    clearBenchStat(&stat);
+    for (i = 0; ok && i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        pushed = pushRing(ring, batch, BENCH_RING_BATCH);
+        while (pushed < BENCH_RING_BATCH)
+        {
+            yield();
+            pushed += pushRing(ring, batch + pushed, BENCH_RING_BATCH - pushed);
+        }
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("ring-spsc", &stat);
+    printBenchRate("ring-spsc-batch/s", &stat);
+
+    // the same transfer with the ring guarded by a semaphore pair per batch
+    benchMeetA();
+    ok = ok && initRing(ring, BENCH_RING_SIZE, NO_OBJECT);
+    clearBenchStat(&stat);
+    for (i = 0; ok && i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        wait(benchRingSpace);
+        pushRing(ring, batch, BENCH_RING_BATCH);
+        post(benchRingData);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    benchMeetA();
+    if (block)
+        freeBlock(block);
+    printBenchResult("ring-sem", &stat);
+    printBenchRate("ring-sem-batch/s", &stat);
+
+    // mutex handoff: both tasks hold the mutex across a yield, so every
+    // unlock hands it to the other task
+    benchMeetA();
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        lock(benchMutex);
+        yield();
+        unlock(benchMutex);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("mutex-handoff", &stat);
+
+    // condition variable round trip: benchB already holds the mutex and
+    // waits, each signal and wait hands the mutex to the other task
+    benchMeetA();
+    lock(benchMutex);
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        condSignal(benchCond);
+        condWait(benchCond, benchMutex);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    condSignal(benchCond);
+    unlock(benchMutex);
+    printBenchResult("cond-rt", &stat);
+
+    // single task tests from here on
+    benchMeetA();
+
+    // yield with nothing else ready at this priority, the kernel returns
+    // without a context switch (yield-rt is the switching case)
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        yield();
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("yield-solo", &stat);
+
+    // sleep(1) jitter, cooperative and then preemptive
+    benchSleep("sleep1-coop", overhead);
+    preempt(true);
+    benchSleep("sleep1-preempt", overhead);
+    preempt(false);
+
+    // usleep(100) from call to return, woken by the microsecond alarm
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_SLEEPS; i++)
+    {
+        start = readCycleCounter();
+        usleep(100);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("usleep100", &stat);
+
+    // 1 ms auto-reload timer, the callback posts benchTick from the work task
+    startTimer(benchTimer, 1, true);
+    wait(benchTick);
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_SLEEPS; i++)
+    {
+        start = readCycleCounter();
+        wait(benchTick);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    stopTimer(benchTimer);
+    printBenchResult("timer1-period", &stat);
+
+    // cost of each non-blocking svc
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        getSemaphoreInfo(&semData, benchPing);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("svc-empty", &stat);
+
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        getPid("BenchA");
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("svc-getpid", &stat);
+
+    // post and wait in pairs so the count never builds up
+    clearBenchStat(&stat);
+    clearBenchStat(&waitStat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        post(benchPong);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+        start = readCycleCounter();
+        wait(benchPong);
+        addBenchSample(&waitStat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("svc-post", &stat);
+    printBenchResult("svc-wait", &waitStat);
+
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        lock(benchMutex);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+        unlock(benchMutex);
+    }
+    printBenchResult("svc-lock", &stat);
+
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        lock(benchMutex);
+        start = readCycleCounter();
+        unlock(benchMutex);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("svc-unlock", &stat);
+
+    // uncontended rw lock, the lock and unlock pair
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        readLock(benchRw);
+        readUnlock(benchRw);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("svc-rw-read", &stat);
+
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        writeLock(benchRw);
+        writeUnlock(benchRw);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("svc-rw-write", &stat);
+
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        setThreadPriority(self, 4);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("svc-priority", &stat);
+
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        preempt(false);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("svc-preempt", &stat);
+
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        getTcb(&psData);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("svc-ps", &stat);
+
+    // non-blocking attempts on a taken semaphore and a held mutex
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        if (tryWait(benchPong))
+            break;
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("svc-trywait", &stat);
+
+    lock(benchMutex);
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        if (tryLock(benchMutex))
+            break;
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    unlock(benchMutex);
+    printBenchResult("svc-trylock", &stat);
+
+    // waitTimeout(1) running out, the spread is the wake-up jitter
+    clearBenchStat(&stat);
+    sleep(1);
+    for (i = 0; i < BENCH_SLEEPS; i++)
+    {
+        start = readCycleCounter();
+        if (waitTimeout(benchPong, 1))
+            break;
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("wait1-timeout", &stat);
+
+    // wake order of a fifo and a priority-ordered semaphore
+    benchWakeOrder("fifo-wake", "fifo-hi-first", benchFifo, overhead);
+    benchWakeOrder("prio-wake", "prio-hi-first", benchPrio, overhead);
+
+    // a thread created above benchA runs, acks and destroys itself, its
+    // stack and record are reused every round
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_SPAWNS; i++)
+    {
+        start = readCycleCounter();
+        if (createThread(benchSpawned, "Spawned", 3, 512) == NO_THREAD)
+            break;
+        wait(benchAck);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("thread-spawn", &stat);
+
+    // a pool job fans out into BENCH_POOL_JOBS more from its worker, the
+    // other worker steals the ones queued on the first worker's deque
+    clearBenchStat(&stat);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        start = readCycleCounter();
+        if (!submitJob(benchPool, benchJob, BENCH_POOL_JOBS))
+            break;
+        for (pushed = 0; pushed <= BENCH_POOL_JOBS; pushed++)
+            wait(benchAck);
+        addBenchSample(&stat, readCycleCounter() - start - overhead);
+    }
+    printBenchResult("pool-fanout", &stat);
+
+    putsUart0("Benchmarks done\n");
+    exitBoard();
+
+    // benchB stays blocked in benchMeetB, leave the cpu to the idle task
+    wait(benchPong);
+}
+
+// Runs the other side of every benchmark
+void benchB(void)
+{
+    uint32_t msg[BENCH_MSG_SIZE / 4];
+    uint32_t *block;
+    RING *ring;
+    uint8_t batch[BENCH_RING_BATCH];
+    uint32_t bytes;
+    uint32_t i;
+
+    benchMeetB();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+        yield();
+
+    benchMeetB();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        wait(benchPing);
+        post(benchPong);
+    }
+
+    benchMeetB();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        waitFlags(benchFlags, 1, FLAGS_ANY | FLAGS_CLEAR, WAIT_FOREVER);
+        setFlags(benchFlags, 2);
+    }
+
+    benchMeetB();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+        receiveMessage(benchQueue, msg, WAIT_FOREVER);
+
+    // the block belongs to benchB between the receive and the send back
+    benchMeetB();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        receiveMessage(benchBlocks, &block, WAIT_FOREVER);
+        block[1] = block[0];
+        sendMessage(benchReturns, &block, WAIT_FOREVER);
+    }
+
+    // benchA stops early (and sends 0) if the ring could not be set up
+    benchMeetB();
+    receiveMessage(benchQueue, msg, WAIT_FOREVER);
+    ring = (RING *)(uintptr_t)msg[0];
+    for (bytes = 0; ring && bytes < BENCH_ROUNDS * BENCH_RING_BATCH; )
+    {
+        i = popRing(ring, batch, BENCH_RING_BATCH);
+        if (!i)
+            wait(benchRingItems);
+        bytes += i;
+    }
+
+    benchMeetB();
+    for (i = 0; ring && i < BENCH_ROUNDS; i++)
+    {
+        wait(benchRingData);
+        popRing(ring, batch, BENCH_RING_BATCH);
+        post(benchRingSpace);
+    }
+    benchMeetB();
+
+    benchMeetB();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        lock(benchMutex);
+        yield();
+        unlock(benchMutex);
+    }
+
+    // the mutex is taken before the meet, so benchA's lock waits for condWait
+    lock(benchMutex);
+    benchMeetB();
+    condWait(benchCond, benchMutex);
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        condSignal(benchCond);
+        condWait(benchCond, benchMutex);
+    }
+    unlock(benchMutex);
+
+    benchMeetB();
+    benchMeetB();
+}
+
+// Timer callback of the timer test, runs in the work task
+void benchTimerFn(uint32_t semaphore)
+{
+    post(semaphore);
+}
+
+// Waiter side of the wake-order tests
+void benchWaiter(uint8_t gate)
+{
+    uint32_t i;
+
+    for (i = 0; i < BENCH_ORDER_ROUNDS; i++)
+    {
+        wait(gate);
+        wait(benchFifo);
+        post(benchAck);
+    }
+    for (i = 0; i < BENCH_ORDER_ROUNDS; i++)
+    {
+        wait(gate);
+        wait(benchPrio);
+        post(benchAck);
+    }
+    wait(gate);
+}
+
+void benchLo(void)
+{
+    benchWaiter(benchGateLo);
+}
+
+void benchHi(void)
+{
+    benchWaiter(benchGateHi);
+}
+
+// Thread created by thread-spawn
+void benchSpawned(void)
+{
+    post(benchAck);
+    destroyThread(getPid("Spawned"));
+}
+
+// Job of pool-fanout, queues fanout more before it acks
+void benchJob(uint32_t fanout)
+{
+    uint32_t i;
+
+    for (i = 0; i < fanout; i++)
+        if (!submitJob(benchPool, benchJob, 0))
+            post(benchAck);
+    post(benchAck);
+}
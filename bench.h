@@ -0,0 +1,85 @@
+// Kernel benchmark tasks
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM (or any board in board.h)
+// System Clock:    40 MHz
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// iterations of each timed loop
+#define BENCH_ROUNDS 1000
+#define BENCH_SLEEPS 100
+
+// follow every table row with a "bench,board,test,avg,min,max,ops" record
+#define BENCH_CSV 1
+
+// trials of each wake-order test
+#define BENCH_ORDER_ROUNDS 20
+
+// queue test: message size and depth, blocks passed around
+#define BENCH_MSG_SIZE 8
+#define BENCH_QUEUE_DEPTH 4
+#define BENCH_BLOCKS 2
+
+// ring test: ring capacity and bytes pushed and popped per call
+#define BENCH_RING_SIZE 512
+#define BENCH_RING_BATCH 8
+
+// allocations timed by the allocator benchmark (must fit next to the stacks)
+#define BENCH_ALLOCS 3
+
+// threads created and destroyed by the spawn test
+#define BENCH_SPAWNS 100
+
+// jobs the first job of the pool test queues (room for all on 2 deques)
+#define BENCH_POOL_JOBS 7
+
+// the benchmarks replace the demo tasks, so they reuse the demo ipc slots
+#define benchMutex 0
+#define benchPing 0
+#define benchPong 1
+#define benchFifo 2
+#define benchPrio 3
+#define benchAck 4
+#define benchGateLo 5
+#define benchGateHi 6
+#define benchFlags 0
+#define benchQueue 0
+#define benchBlocks 1
+#define benchReturns 2
+#define benchRingItems 7
+#define benchRingSpace 8
+#define benchRingData 9
+#define benchCond 0
+#define benchRw 0
+#define benchTick 10
+#define benchTimer 0
+#define benchPool 0
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+bool initBench(void);
+
+void benchA(void);
+void benchB(void);
+void benchLo(void);
+void benchHi(void);
+void benchSpawned(void);
+void benchJob(uint32_t fanout);
+void benchTimerFn(uint32_t semaphore);
+
+#endif
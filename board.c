@@ -0,0 +1,118 @@
+// Board support functions
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL Evaluation Board
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// 16/32-bit Timer 5A:
+//   32-bit periodic up counter at the system clock, used as the cycle counter
+// 32/64-bit Wide Timer 0 (A+B):
+//   64-bit periodic up counter at the system clock, read by now_us(), its
+//   match interrupt (INT_WTIMER0A) wakes the tasks in usleep()
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "kernel.h"
+#include "board.h"
+
+#define CYCLES_PER_US (BOARD_CLOCK_HZ / 1000000)
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Starts Timer 5A counting up from 0 at 40 MHz, must be called privileged
+void initCycleCounter(void)
+{
+    SYSCTL_RCGCTIMER_R |= SYSCTL_RCGCTIMER_R5;
+    _delay_cycles(3);
+
+    TIMER5_CTL_R &= ~TIMER_CTL_TAEN;                    // turn-off timer before reconfiguring
+    TIMER5_CFG_R = TIMER_CFG_32_BIT_TIMER;              // configure as 32-bit timer (A+B)
+    TIMER5_TAMR_R = TIMER_TAMR_TAMR_PERIOD | TIMER_TAMR_TACDIR; // periodic mode, count up
+    TIMER5_TAILR_R = 0xFFFFFFFF;                        // wrap after 2^32 cycles (107 s)
+    TIMER5_CTL_R |= TIMER_CTL_TAEN;                     // turn-on timer
+}
+
+// Returns the running cycle count, callable from tasks
+uint32_t readCycleCounter(void)
+{
+    return TIMER5_TAV_R;
+}
+
+// Starts Wide Timer 0 counting up from 0 at 40 MHz with the match interrupt
+// off, must be called privileged
+void initMicroTimer(void)
+{
+    SYSCTL_RCGCWTIMER_R |= SYSCTL_RCGCWTIMER_R0;
+    _delay_cycles(3);
+
+    WTIMER0_CTL_R &= ~TIMER_CTL_TAEN;                   // turn-off timer before reconfiguring
+    WTIMER0_CFG_R = TIMER_CFG_32_BIT_TIMER;             // on a wide timer this is 64-bit (A+B)
+    WTIMER0_TAMR_R = TIMER_TAMR_TAMR_PERIOD | TIMER_TAMR_TACDIR | TIMER_TAMR_TAMIE;
+    WTIMER0_TBILR_R = 0xFFFFFFFF;                       // wrap after 2^64 cycles
+    WTIMER0_TAILR_R = 0xFFFFFFFF;
+    WTIMER0_IMR_R = 0;
+    WTIMER0_ICR_R = TIMER_ICR_TAMCINT;
+    ((volatile uint8_t *)&NVIC_PRI0_R)[INT_WTIMER0A - 16] = KERNEL_PRIORITY;
+    NVIC_EN2_R = 1 << (INT_WTIMER0A - 16 - 64);
+    WTIMER0_CTL_R |= TIMER_CTL_TAEN;                    // turn-on timer
+}
+
+// Reads the 64-bit count, again if the low half carried into the high half
+// in between
+uint64_t readWideTimer(void)
+{
+    uint32_t high;
+    uint32_t low;
+
+    do
+    {
+        high = WTIMER0_TBV_R;
+        low = WTIMER0_TAV_R;
+    } while (high != WTIMER0_TBV_R);
+
+    return ((uint64_t)high << 32) | low;
+}
+
+// Returns the microseconds since initMicroTimer, callable from tasks
+uint64_t now_us(void)
+{
+    return readWideTimer() / CYCLES_PER_US;
+}
+
+// Raises the match interrupt when now_us() reaches us
+// Returns false if us had already passed once the match was set
+bool setMicroAlarm(uint64_t us)
+{
+    uint64_t match = us * CYCLES_PER_US;
+
+    WTIMER0_IMR_R &= ~TIMER_IMR_TAMIM;
+    WTIMER0_ICR_R = TIMER_ICR_TAMCINT;
+    WTIMER0_TBMATCHR_R = match >> 32;                   // high half first
+    WTIMER0_TAMATCHR_R = (uint32_t)match;
+    WTIMER0_IMR_R |= TIMER_IMR_TAMIM;
+    return readWideTimer() < match;
+}
+
+void stopMicroAlarm(void)
+{
+    WTIMER0_IMR_R &= ~TIMER_IMR_TAMIM;
+    WTIMER0_ICR_R = TIMER_ICR_TAMCINT;
+}
+
+// Nothing to leave on real hardware
+void exitBoard(void)
+{
+}
@@ -0,0 +1,55 @@
+// Board support functions
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL Evaluation Board (default)
+//                  QEMU mps2-an386 Cortex-M4 model (BOARD_QEMU, see qemu/)
+//                  host simulation (RTOS_SIM, see sim/)
+
+// The drivers behind clock.h, uart0.h, gpio.h and wait.h are supplied per
+// board (the TM4C versions live in the project root, the others in qemu/ and
+// sim/). This header covers what is left: the core clock and a cycle counter
+// that unprivileged tasks can read. DWT CYCCNT and SysTick sit on the private
+// peripheral bus, which faults in thread mode, so each board uses a free
+// running timer on the regular peripheral bus instead.
+// The microsecond clock is 64 bits wide so it never wraps, its alarm raises
+// microTimerIsr() (kernel.c) and is only set and stopped by the kernel.
+
+#ifndef BOARD_H_
+#define BOARD_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef BOARD_QEMU
+#define BOARD_NAME      "qemu-mps2-an386"
+#define BOARD_CLOCK_HZ  25000000
+#elif defined(RTOS_SIM)
+#define BOARD_NAME      "host-sim"
+#define BOARD_CLOCK_HZ  40000000
+#else
+#define BOARD_NAME      "ek-tm4c123gxl"
+#define BOARD_CLOCK_HZ  40000000
+#endif
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initCycleCounter(void);
+uint32_t readCycleCounter(void);
+void exitBoard(void);
+
+void initMicroTimer(void);
+uint64_t now_us(void);
+bool setMicroAlarm(uint64_t us);
+void stopMicroAlarm(void);
+
+#endif
@@ -18,6 +18,8 @@
 #include "uart0.h"
 #include "uartio.h"
 #include "spctl.h"
+#include "log.h"
+#include "trace.h"
 #include "faults.h"
 
 uint16_t pid = 0;
@@ -40,61 +42,25 @@ void mpuFaultIsr(void)
     uint32_t *psp = getPsp();
     uint32_t *msp = getMsp();
 
-    char buf[MAX_CHARS];
-
-    putsUart0("MPU fault in process ");
-    putsUart0(IntToString(pid, buf));
-    putsUart0("\n");
-
-    putsUart0(" PSP \t\t");
-    putsUart0(HexToString((uint32_t)psp, buf));
-    putsUart0("\n");
-
-    putsUart0(" MSP \t\t");
-    putsUart0(HexToString((uint32_t)msp, buf));
-    putsUart0("\n");
-
-    putsUart0(" MFAULT FLAGS\t");
-    putsUart0(HexToString(NVIC_FAULT_STAT_R & 0x000000FF, buf));
-    putsUart0("\n");
-
-    putsUart0(" MEM ADDR\t");
-    putsUart0(HexToString(NVIC_MM_ADDR_R, buf));
-    putsUart0("\n");
-
-    putsUart0(" xPSR\t\t");
-    putsUart0(HexToString((uint32_t)stack[7], buf));
-    putsUart0("\n");
-
-    putsUart0(" PC\t\t");
-    putsUart0(HexToString((uint32_t)stack[6], buf));
-    putsUart0("\n");
-
-    putsUart0(" LR\t\t");
-    putsUart0(HexToString((uint32_t)stack[5], buf));
-    putsUart0("\n");
-
-    putsUart0(" R0\t\t");
-    putsUart0(HexToString((uint32_t)stack[0], buf));
-    putsUart0("\n");
-
-    putsUart0(" R1\t\t");
-    putsUart0(HexToString((uint32_t)stack[1], buf));
-    putsUart0("\n");
-
-    putsUart0(" R2\t\t");
-    putsUart0(HexToString((uint32_t)stack[2], buf));
-    putsUart0("\n");
-
-    putsUart0(" R3\t\t");
-    putsUart0(HexToString((uint32_t)stack[3], buf));
-    putsUart0("\n");
-
-    putsUart0(" R12\t\t");
-    putsUart0(HexToString((uint32_t)stack[4], buf));
-    putsUart0("\n");
-
-    putsUart0("\n");
+    traceEvent(TRACE_FAULT, 4);
+
+    LOG("MPU fault in process %u\n", pid);
+    LOG(" PSP \t\t0x%08X\n", (uint32_t)psp);
+    LOG(" MSP \t\t0x%08X\n", (uint32_t)msp);
+    LOG(" MFAULT FLAGS\t0x%08X\n", NVIC_FAULT_STAT_R & 0x000000FF);
+    LOG(" MEM ADDR\t0x%08X\n", NVIC_MM_ADDR_R);
+    LOG(" xPSR\t\t0x%08X\n", stack[7]);
+    LOG(" PC\t\t0x%08X\n", stack[6]);
+    LOG(" LR\t\t0x%08X\n", stack[5]);
+    LOG(" R0\t\t0x%08X\n", stack[0]);
+    LOG(" R1\t\t0x%08X\n", stack[1]);
+    LOG(" R2\t\t0x%08X\n", stack[2]);
+    LOG(" R3\t\t0x%08X\n", stack[3]);
+    LOG(" R12\t\t0x%08X\n\n", stack[4]);
+
+#if TRACE_DUMP_ON_FAULT
+    traceDump();
+#endif
 
     NVIC_SYS_HND_CTRL_R |= !NVIC_SYS_HND_CTRL_MEMP;
     NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
@@ -106,25 +72,16 @@ void hardFaultIsr(void)
     uint32_t *psp = getPsp();
     uint32_t *msp = getMsp();
 
-    char buf[MAX_CHARS];
-
-    putsUart0("Hard fault in process ");
-    putsUart0(IntToString((uint32_t)pid, buf));
-    putsUart0("\n");
-
-    putsUart0(" PSP \t\t");
-    putsUart0(HexToString((uint32_t)psp, buf));
-    putsUart0("\n");
-
-    putsUart0(" MSP \t\t");
-    putsUart0(HexToString((uint32_t)msp, buf));
-    putsUart0("\n");
+    traceEvent(TRACE_FAULT, 3);
 
-    putsUart0(" HFAULT FLAGS\t");
-    putsUart0(HexToString(NVIC_HFAULT_STAT_R, buf));
-    putsUart0("\n");
+    LOG("Hard fault in process %u\n", pid);
+    LOG(" PSP \t\t0x%08X\n", (uint32_t)psp);
+    LOG(" MSP \t\t0x%08X\n", (uint32_t)msp);
+    LOG(" HFAULT FLAGS\t0x%08X\n\n", NVIC_HFAULT_STAT_R);
 
-    putsUart0("\n");
+#if TRACE_DUMP_ON_FAULT
+    traceDump();
+#endif
 
     while(true);
 }
@@ -132,11 +89,12 @@ void hardFaultIsr(void)
 // REQUIRED: code this function
 void busFaultIsr(void)
 {
-    char buf[MAX_CHARS];
+    traceEvent(TRACE_FAULT, 5);
+    LOG("Bus fault in process %u\n\n", pid);
 
-    putsUart0("Bus fault in process ");
-    putsUart0(IntToString(pid, buf));
-    putsUart0("\n\n");
+#if TRACE_DUMP_ON_FAULT
+    traceDump();
+#endif
 
     while(true);
 }
@@ -144,11 +102,12 @@ void busFaultIsr(void)
 // REQUIRED: code this function
 void usageFaultIsr(void)
 {
-    char buf[MAX_CHARS];
+    traceEvent(TRACE_FAULT, 6);
+    LOG("Usage fault in process %u\n\n", pid);
 
-    putsUart0("Usage fault in process ");
-    putsUart0(IntToString(pid, buf));
-    putsUart0("\n\n");
+#if TRACE_DUMP_ON_FAULT
+    traceDump();
+#endif
 
     while(true);
 }
@@ -20,6 +20,9 @@
 #include "mm.h"
 #include "spctl.h"
 #include "kernel.h"
+#include "trace.h"
+#include "board.h"
+#include "log.h"
 
 #include "gpio.h"
 
@@ -27,71 +30,378 @@
 // RTOS Defines and Kernel Variables
 //-----------------------------------------------------------------------------
 
+#define NUM_PRIORITIES   8
+
+// wait list, the waiting tasks are linked through tcb[].next and tcb[].prev
+// so queueing, waking and removing a killed waiter are all O(1)
+// the list is kept in wake order: by priority for priority-ordered objects,
+// FIFO otherwise (every waiter is queued at key 0), with the last task of
+// each key in tail[] and the keys present in a bitmap
+#define NO_TASK 0xFF
+typedef struct _waitList
+{
+    uint8_t head;                  // next task to wake, NO_TASK if empty
+    uint8_t tail[NUM_PRIORITIES];  // last task queued with each key
+    uint8_t keys;                  // bit k set if tail[k] is valid
+} waitList;
+
 // mutex
 typedef struct _mutex
 {
+    bool inUse;                    // allocated from the pool
     bool lock;
+    bool priorityOrder;            // wake the highest priority waiter first
     uint8_t queueSize;
-    uint8_t processQueue[MAX_MUTEX_QUEUE_SIZE];
     uint8_t lockedBy;
+    waitList waiters;
 } mutex;
 mutex mutexes[MAX_MUTEXES];
 
 // semaphore
 typedef struct _semaphore
 {
+    bool inUse;                    // allocated from the pool
+    bool priorityOrder;            // wake the highest priority waiter first
     uint8_t count;
     uint8_t queueSize;
-    uint8_t processQueue[MAX_SEMAPHORE_QUEUE_SIZE];
+    waitList waiters;
 } semaphore;
 semaphore semaphores[MAX_SEMAPHORES];
 
+// event group
+typedef struct _eventGroup
+{
+    bool inUse;                    // allocated from the pool
+    uint8_t queueSize;
+    uint32_t flags;
+    waitList waiters;              // FIFO, a set checks every waiter anyway
+} eventGroup;
+eventGroup eventGroups[MAX_EVENT_GROUPS];
+
+// message queue, a ring of depth messages in queueBuffer
+// a block queue (msgSize BLOCK_MESSAGE) carries block pointers and moves the
+// block's MPU subregion from the sender to the receiver instead of copying
+typedef struct _queue
+{
+    bool inUse;                    // allocated from the pool
+    bool blocks;                   // zero-copy block queue
+    uint8_t msgSize;
+    uint8_t depth;
+    uint8_t head;                  // oldest message
+    uint8_t count;
+    uint16_t buffer;               // offset of the ring in queueBuffer
+    waitList senders;              // waiting for room
+    waitList receivers;            // waiting for a message
+} queue;
+queue queues[MAX_QUEUES];
+uint8_t queueBuffer[QUEUE_BUFFER_SIZE];
+uint16_t queueBufferUsed = 0;
+
+// deferred work, a copy queue of function and argument pairs that interrupt
+// handlers fill and the work task empties
+typedef struct _workItem
+{
+    _workFn fn;
+    uint32_t arg;
+} workItem;
+uint8_t workQueue = NO_OBJECT;
+
+// worker pool, the jobs are work items too
+// submitJob adds to the back of the worker deques in turn, a worker takes the
+// oldest job from the front of its own deque and, once that is empty, steals
+// the newest one from the back of the fullest deque of its pool
+typedef struct _jobDeque
+{
+    _thread worker;                // thread that owns it, a record reused
+                                   // by another thread does not match
+    uint8_t pool;
+    uint8_t head;                  // oldest job
+    uint8_t count;
+    workItem jobs[POOL_DEQUE_DEPTH];
+} jobDeque;
+jobDeque jobDeques[MAX_POOL_WORKERS];
+uint8_t jobDequesUsed = 0;
+
+typedef struct _pool
+{
+    bool inUse;                    // allocated from the pool
+    uint8_t first;                 // deque of its first worker, the others follow
+    uint8_t workers;
+    uint8_t next;                  // worker whose deque gets the next job
+    uint8_t idle;                  // semaphore its workers wait on while there is no job
+} pool;
+pool pools[MAX_POOLS];
+
+// software timer, the running ones are linked in expiry order from timerHead
+// and SysTick queues their callbacks for the work task
+typedef struct _swTimer
+{
+    bool inUse;                    // allocated from the pool
+    bool running;
+    bool autoReload;               // restarts with the same period when it runs out
+    uint8_t next;                  // next running timer, NO_OBJECT at the end
+    uint32_t period;
+    uint32_t expiry;               // tickCount it runs out at
+    _workFn fn;
+    uint32_t arg;
+} swTimer;
+swTimer timers[MAX_TIMERS];
+uint8_t timerHead = NO_OBJECT;
+
+// ticks since startRtos
+uint32_t tickCount = 0;
+
+// now_us() the microsecond alarm is set for, 0 while no task is in usleep
+uint64_t microAlarm = 0;
+
+// condition variable, a signal moves a waiter to the wait list of the mutex
+// it released, so it wakes up holding the mutex again
+typedef struct _condVar
+{
+    bool inUse;                    // allocated from the pool
+    uint8_t queueSize;
+    waitList waiters;              // FIFO
+} condVar;
+condVar condVars[MAX_COND_VARS];
+
+// readers-writer lock, writers go first: a reader waits while a writer holds
+// the lock or waits for it, but a write unlock lets every reader already
+// waiting in before the next writer, so neither side starves
+typedef struct _rwLock
+{
+    bool inUse;                    // allocated from the pool
+    bool writer;                   // held for writing by writerTask
+    uint8_t writerTask;
+    uint8_t readers;
+    uint16_t readerMask;           // bit per task holding it for reading
+    uint8_t readQueueSize;
+    uint8_t writeQueueSize;
+    uint16_t readContended;        // locks that had to wait, for ipcs
+    uint16_t writeContended;
+    waitList readWaiters;          // FIFO
+    waitList writeWaiters;         // FIFO
+} rwLock;
+rwLock rwLocks[MAX_RW_LOCKS];
+
+// message blocks, owned by a task, free or queued
+#define BLOCK_FREE   0xFF
+#define BLOCK_QUEUED 0xFE
+uint8_t *blockBase = 0;
+uint8_t blockCount = 0;
+uint8_t blockOwner[MAX_BLOCKS];
+uint8_t blockSharer[MAX_BLOCKS];   // second task with access, NO_TASK if none
+
+// fails to compile (negative array size) when the sizes in kernel.h leave
+// no room for the rest of SRAM, the host simulation has 64-bit pointers in
+// these and keeps them out of the simulated SRAM
+#ifndef RTOS_SIM
+typedef char poolRamCheck[(sizeof(mutexes) + sizeof(semaphores) + sizeof(eventGroups)
+                           + sizeof(queues) + sizeof(queueBuffer) + sizeof(jobDeques)
+                           + sizeof(pools) + sizeof(timers) + sizeof(condVars)
+                           + sizeof(rwLocks) + sizeof(blockOwner) + sizeof(blockSharer)
+                           <= POOL_RAM) ? 1 : -1];
+#endif
+
 // task states
 #define STATE_INVALID           0 // no task
 #define STATE_STOPPED           1 // stopped, can be resumed
 #define STATE_UNRUN             2 // task has never been run
 #define STATE_READY             3 // has run, can resume at any time
 #define STATE_DELAYED           4 // has run, but now awaiting timer
-#define STATE_BLOCKED_MUTEX     5 // has run, but now blocked by semaphore
-#define STATE_BLOCKED_SEMAPHORE 6 // has run, but now blocked by semaphore
+#define STATE_DELAYED_US        5 // has run, but now awaiting the microsecond timer
+#define STATE_BLOCKED_MUTEX     6 // has run, but now blocked by semaphore
+#define STATE_BLOCKED_SEMAPHORE 7 // has run, but now blocked by semaphore
+#define STATE_BLOCKED_FLAGS     8 // has run, but now waiting for event flags
+#define STATE_BLOCKED_SEND      9 // has run, but now waiting for queue space
+#define STATE_BLOCKED_RECEIVE   10 // has run, but now waiting for a message
+#define STATE_BLOCKED_COND      11 // has run, but now waiting for a signal
+#define STATE_BLOCKED_READ      12 // has run, but now waiting to read a rw lock
+#define STATE_BLOCKED_WRITE     13 // has run, but now waiting to write a rw lock
+// every state from STATE_BLOCKED_MUTEX on is a wait on an ipc object
 
 // task
 uint8_t taskCurrent = 0;          // index of last dispatched task
 uint8_t taskCount = 0;            // total number of valid tasks
 
+// idle task, the cycles spent in it (hook included) and the hook it calls
+uint8_t taskIdle = NO_TASK;
+uint64_t idleCycles = 0;
+uint32_t idleStart = 0;           // cycle counter when it was switched in
+_fn idleHook = 0;
+
+// set when a task of higher priority than the current one is made ready,
+// lets the FromIsr functions skip PendSV when nothing would change
+bool higherReady = false;
+
 // control
 bool priorityScheduler = true;    // priority (true) or round-robin (false)
-bool priorityInheritance = false; // priority inheritance for mutexes
+bool priorityInheritance = false; // priority inheritance for mutexes and rw locks
 bool preemption = false;          // preemption (true) or cooperative (false)
 
 // tcb
-#define NUM_PRIORITIES   8
 struct _tcb
 {
     uint8_t state;                 // see STATE_ values above
+    uint8_t generation;            // times the record was taken, high byte of the handle
     void *pid;                     // used to uniquely identify thread (add of task fn)
     void *spInit;                  // original top of stack
     void *sp;                      // current stack pointer
     uint8_t priority;              // 0=highest
-    uint8_t currentPriority;       // 0=highest (needed for pi)
-    uint32_t ticks;                // ticks until sleep complete
+    uint8_t currentPriority;       // 0=highest, priority raised by pi, used by the scheduler
+    uint32_t ticks;                // ticks until sleep complete (or timed wait expires),
+                                   // the now_us() it wakes at for usleep
     uint8_t srd[NUM_SRAM_REGIONS]; // MPU subregion disable bits
     char name[16];                 // name of task used in ps command
+    uint8_t nameNext;              // next task in the same nameIndex bucket
     uint8_t mutex;                 // index of the mutex in use or blocking the thread
     uint8_t semaphore;             // index of the semaphore that is blocking the thread
+    uint8_t group;                 // index of the event group the thread waits on
+    uint32_t flagMask;             // flags it waits for
+    uint8_t flagMode;              // FLAGS_ALL, FLAGS_CLEAR
+    uint8_t queue;                 // index of the queue the thread waits on
+    bool urgent;                   // blocked send goes to the front
+    uint8_t *msg;                  // message to send or buffer to receive into
+    uint8_t condVar;               // index of the condition variable the thread waits on
+    uint8_t rwLock;                // index of the rw lock the thread waits on
+    uint8_t next;                  // neighbours in the wait list of the blocking object
+    uint8_t prev;
+    uint8_t waitKey;               // wait list key, the priority or 0 for FIFO
+    uint32_t *waitResult;          // stacked R0 of a timed or flag wait, 0 otherwise
+    uint8_t sliceLeft;             // ticks left of its quantum
+    uint32_t switches;             // times it was switched in
+    uint32_t sliceEnds;            // times its quantum ran out and it was preempted
 } tcb[MAX_TASKS];
 
+// tasks by name for getPid, each bucket is a list through tcb.nameNext
+#define NAME_BUCKETS 16
+uint8_t nameIndex[NAME_BUCKETS];
+
+// round-robin quantum of each priority in ticks, see setQuantum
+uint8_t quantum[NUM_PRIORITIES] = {1, 1, 1, 1, 1, 1, 1, 1};
+
+// SVC argument kinds, see syscalls.h
+#define ARG_NONE      0
+#define ARG_VALUE     1
+#define ARG_BOOL      2
+#define ARG_MUTEX     3 // MUTEX to POOL are object indices
+#define ARG_SEMAPHORE 4
+#define ARG_GROUP     5
+#define ARG_QUEUE     6
+#define ARG_COND      7
+#define ARG_RW        8
+#define ARG_TIMER     9
+#define ARG_POOL      10
+#define ARG_PRIORITY  11
+#define ARG_THREAD    12
+#define ARG_STRING    13
+#define ARG_IN        14
+#define ARG_OUT       15
+#define ARG_MSG_IN    16
+#define ARG_MSG_OUT   17
+
+// what tasks can always read besides their SRAM
+#define FLASH_SIZE 0x00040000
+
+typedef struct _svcArg
+{
+    uint8_t kind;                  // see ARG_ values above
+    uint16_t size;                 // bytes behind a pointer
+} svcArg;
+
+// entry of the SVC table, R0-R3 are checked against arg before handler runs
+typedef struct _svcCall
+{
+    uint32_t (*handler)(uint32_t args[]);
+    svcArg arg[4];
+} svcCall;
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
 
+void initWaitList(waitList *list)
+{
+    list->head = NO_TASK;
+    list->keys = 0;
+}
+
+// Queues a task behind every waiter with the same or a lower key
+void addWaiter(waitList *list, uint8_t task, uint8_t key)
+{
+    uint8_t before = list->keys & ((2 << key) - 1);
+    uint8_t closest = key;
+    uint8_t prev = NO_TASK;
+    uint8_t next;
+
+    // the closest key at or below ours holds the task to insert after
+    if (before)
+    {
+        while (!(before & (1 << closest)))
+            closest--;
+        prev = list->tail[closest];
+    }
+
+    next = (prev == NO_TASK) ? list->head : tcb[prev].next;
+    tcb[task].prev = prev;
+    tcb[task].next = next;
+    if (prev == NO_TASK)
+        list->head = task;
+    else
+        tcb[prev].next = task;
+    if (next != NO_TASK)
+        tcb[next].prev = task;
+
+    tcb[task].waitKey = key;
+    list->tail[key] = task;
+    list->keys |= 1 << key;
+}
+
+// Unlinks a task from anywhere in a wait list
+void removeWaiter(waitList *list, uint8_t task)
+{
+    uint8_t key = tcb[task].waitKey;
+    uint8_t prev = tcb[task].prev;
+    uint8_t next = tcb[task].next;
+
+    if (list->tail[key] == task)
+    {
+        if (prev != NO_TASK && tcb[prev].waitKey == key)
+            list->tail[key] = prev;
+        else
+            list->keys &= ~(1 << key);
+    }
+
+    if (prev == NO_TASK)
+        list->head = next;
+    else
+        tcb[prev].next = next;
+    if (next != NO_TASK)
+        tcb[next].prev = prev;
+
+    tcb[task].next = NO_TASK;
+    tcb[task].prev = NO_TASK;
+}
+
+// Removes and returns the first task of a wait list
+uint8_t takeWaiter(waitList *list)
+{
+    uint8_t task = list->head;
+    if (task != NO_TASK)
+        removeWaiter(list, task);
+    return task;
+}
+
 bool initMutex(uint8_t mutex)
 {
     bool ok = (mutex < MAX_MUTEXES);
     if (ok)
     {
+        mutexes[mutex].inUse = true;
+        mutexes[mutex].priorityOrder = false;
         mutexes[mutex].lock = false;
         mutexes[mutex].lockedBy = 0;
+        mutexes[mutex].queueSize = 0;
+        initWaitList(&mutexes[mutex].waiters);
     }
     return ok;
 }
@@ -99,563 +409,2308 @@ bool initMutex(uint8_t mutex)
 bool initSemaphore(uint8_t semaphore, uint8_t count)
 {
     bool ok = (semaphore < MAX_SEMAPHORES);
+    if (ok)
     {
+        semaphores[semaphore].inUse = true;
+        semaphores[semaphore].priorityOrder = false;
         semaphores[semaphore].count = count;
+        semaphores[semaphore].queueSize = 0;
+        initWaitList(&semaphores[semaphore].waiters);
     }
     return ok;
 }
 
-// REQUIRED: initialize systick for 1ms system timer
-void initRtos(void)
+bool initEventGroup(uint8_t group)
 {
-    uint8_t i;
-    // no tasks running
-    taskCount = 0;
-    // clear out tcb records
-    for (i = 0; i < MAX_TASKS; i++)
+    bool ok = (group < MAX_EVENT_GROUPS);
+    if (ok)
     {
-        tcb[i].state = STATE_INVALID;
-        tcb[i].pid = 0;
+        eventGroups[group].inUse = true;
+        eventGroups[group].flags = 0;
+        eventGroups[group].queueSize = 0;
+        initWaitList(&eventGroups[group].waiters);
     }
-
-    NVIC_ST_RELOAD_R = 39999; // (40Mhz / 1khz) - 1
-                      // clock source        enable int           enable systick
-    NVIC_ST_CTRL_R |= NVIC_ST_CTRL_CLK_SRC | NVIC_ST_CTRL_INTEN | NVIC_ST_CTRL_ENABLE;
+    return ok;
 }
 
-// REQUIRED: Implement prioritization to NUM_PRIORITIES
-uint8_t rtosScheduler(void)
+bool initCondVar(uint8_t cv)
 {
-    bool ok;
-    static uint8_t task = 0xFF;
-    static uint8_t last_task[7] = {0, 0, 0, 0, 0, 0, 0};
-    ok = false;
-
-    if (priorityScheduler)
+    bool ok = (cv < MAX_COND_VARS);
+    if (ok)
     {
-        uint8_t highest_priority = 0;
-        task = last_task[highest_priority] + 1;
-
-        while (!ok)
-        {
-            ok = (tcb[task].priority == highest_priority && (tcb[task].state == STATE_READY || tcb[task].state == STATE_UNRUN));
-            if (!ok)
-            {
-                task++;
-                if (task >= MAX_TASKS)
-                {
-                    task = 0;
-                }
-                if (task == last_task[highest_priority] + 1)
-                {
-                    highest_priority++;
-                    if (highest_priority > 7)
-                        highest_priority = 0;
-                    task = last_task[highest_priority] + 1;
-                }
-            }
-        }
-        last_task[highest_priority] = task;
-        return task;
+        condVars[cv].inUse = true;
+        condVars[cv].queueSize = 0;
+        initWaitList(&condVars[cv].waiters);
     }
-    else
+    return ok;
+}
+
+bool initRwLock(uint8_t rw)
+{
+    bool ok = (rw < MAX_RW_LOCKS);
+    if (ok)
     {
-        while (!ok)
-        {
-            task++;
-            if (task >= MAX_TASKS)
-                task = 0;
-            ok = (tcb[task].state == STATE_READY || tcb[task].state == STATE_UNRUN);
-        }
-        return task;
+        rwLocks[rw].inUse = true;
+        rwLocks[rw].writer = false;
+        rwLocks[rw].writerTask = NO_TASK;
+        rwLocks[rw].readers = 0;
+        rwLocks[rw].readerMask = 0;
+        rwLocks[rw].readQueueSize = 0;
+        rwLocks[rw].writeQueueSize = 0;
+        rwLocks[rw].readContended = 0;
+        rwLocks[rw].writeContended = 0;
+        initWaitList(&rwLocks[rw].readWaiters);
+        initWaitList(&rwLocks[rw].writeWaiters);
     }
+    return ok;
 }
 
-// REQUIRED: modify this function to start the operating system
-// by calling scheduler, set srd bits, setting PSP, ASP bit, call fn with fn add in R0
-// fn set TMPL bit, and PC <= fn
-void startRtos(void)
+// Allocates a mutex from the pool (before startRtos, like initMutex)
+// Returns NO_OBJECT if the pool is used up
+uint8_t createMutex(void)
 {
-    taskCurrent = rtosScheduler();
-    applySramSrdMasks(tcb[taskCurrent].srd);
-    setPsp((uint32_t)tcb[taskCurrent].sp); // sets psp to first tasks' sp
-    tcb[taskCurrent].state = STATE_READY;
-    usePsp();
-    setPcTmpl(tcb[taskCurrent].pid); // enables privileged mode
+    uint8_t mutex = 0;
+
+    while (mutex < MAX_MUTEXES && mutexes[mutex].inUse)
+        mutex++;
+
+    if (mutex == MAX_MUTEXES)
+        return NO_OBJECT;
+
+    initMutex(mutex);
+    return mutex;
 }
 
-// REQUIRED:
-// add task if room in task list - done
-// store the thread name
-// allocate stack space and store top of stack in sp and spInit - done
-// set the srd bits based on the memory allocation - done
-bool createThread(_fn fn, const char name[], uint8_t priority, uint32_t stackBytes)
+// Allocates a semaphore from the pool (before startRtos, like initSemaphore)
+// Returns NO_OBJECT if the pool is used up
+uint8_t createSemaphore(uint8_t count)
 {
-    bool ok = false;
-    uint8_t i = 0;
-    bool found = false;
-    if (taskCount < MAX_TASKS)
-    {
-        // make sure fn not already in list (prevent reentrancy)
-        while (!found && (i < MAX_TASKS))
-        {
-            found = (tcb[i++].pid ==  fn);
-        }
-        if (!found)
-        {
-            // find first available tcb record
-            i = 0;
-            while (tcb[i].state != STATE_INVALID) {i++;}
+    uint8_t semaphore = 0;
 
-            tcb[i].state = STATE_UNRUN;
-            tcb[i].pid = fn;
-            tcb[i].spInit = (void *) ((uint32_t)mallocFromHeap(stackBytes) + (stackBytes - 1));
-            tcb[i].sp = tcb[i].spInit;
-            tcb[i].priority = priority;
-            CopyStrings((char*)name, tcb[i].name);
-            // tcb[i].name[0] = i + 65;
-            //tcb[i].name[1] = 0;
-            generateSramSrdMasks(tcb[i].srd, tcb[i].spInit, stackBytes); //spinit - (stackBytes + 1)
+    while (semaphore < MAX_SEMAPHORES && semaphores[semaphore].inUse)
+        semaphore++;
 
-            // increment task count
-            taskCount++;
-            ok = true;
-        }
+    if (semaphore == MAX_SEMAPHORES)
+        return NO_OBJECT;
+
+    initSemaphore(semaphore, count);
+    return semaphore;
+}
+
+// Allocates an event group from the pool (before startRtos, like initEventGroup)
+// Returns NO_OBJECT if the pool is used up
+uint8_t createEventGroup(void)
+{
+    uint8_t group = 0;
+
+    while (group < MAX_EVENT_GROUPS && eventGroups[group].inUse)
+        group++;
+
+    if (group == MAX_EVENT_GROUPS)
+        return NO_OBJECT;
+
+    initEventGroup(group);
+    return group;
+}
+
+// Allocates a condition variable from the pool (before startRtos, like initCondVar)
+// Returns NO_OBJECT if the pool is used up
+uint8_t createCondVar(void)
+{
+    uint8_t cv = 0;
+
+    while (cv < MAX_COND_VARS && condVars[cv].inUse)
+        cv++;
+
+    if (cv == MAX_COND_VARS)
+        return NO_OBJECT;
+
+    initCondVar(cv);
+    return cv;
+}
+
+// Allocates a rw lock from the pool (before startRtos, like initRwLock)
+// Returns NO_OBJECT if the pool is used up
+uint8_t createRwLock(void)
+{
+    uint8_t rw = 0;
+
+    while (rw < MAX_RW_LOCKS && rwLocks[rw].inUse)
+        rw++;
+
+    if (rw == MAX_RW_LOCKS)
+        return NO_OBJECT;
+
+    initRwLock(rw);
+    return rw;
+}
+
+// Allocates a queue of depth messages of msgSize bytes (before startRtos)
+// msgSize BLOCK_MESSAGE makes a zero-copy queue of message blocks
+// Returns NO_OBJECT if the pool or queueBuffer is used up
+uint8_t createQueue(uint8_t msgSize, uint8_t depth)
+{
+    uint8_t q = 0;
+    bool blocks = (msgSize == BLOCK_MESSAGE);
+
+    if (blocks)
+        msgSize = sizeof(void *);
+
+    while (q < MAX_QUEUES && queues[q].inUse)
+        q++;
+
+    if (q == MAX_QUEUES || !depth || queueBufferUsed + msgSize * depth > QUEUE_BUFFER_SIZE)
+        return NO_OBJECT;
+
+    queues[q].inUse = true;
+    queues[q].blocks = blocks;
+    queues[q].msgSize = msgSize;
+    queues[q].depth = depth;
+    queues[q].head = 0;
+    queues[q].count = 0;
+    queues[q].buffer = queueBufferUsed;
+    initWaitList(&queues[q].senders);
+    initWaitList(&queues[q].receivers);
+    queueBufferUsed += msgSize * depth;
+    return q;
+}
+
+// Creates the work queue and the task that runs its items (before startRtos)
+// Give the task a priority above the tasks the deferred work and the timer
+// callbacks serve
+bool initWorkQueue(uint8_t priority, uint32_t stackBytes)
+{
+    if (workQueue != NO_OBJECT)
+        return false;
+
+    workQueue = createQueue(sizeof(workItem), WORK_QUEUE_DEPTH);
+    return workQueue != NO_OBJECT && createThread(workTask, "Work", priority, stackBytes);
+}
+
+// Allocates a timer that runs fn(arg) in the work task each time it runs out
+// (before startRtos, timers need initWorkQueue)
+// Returns NO_OBJECT if the pool is used up
+uint8_t createTimer(_workFn fn, uint32_t arg)
+{
+    uint8_t timer = 0;
+
+    while (timer < MAX_TIMERS && timers[timer].inUse)
+        timer++;
+
+    if (timer == MAX_TIMERS || !fn)
+        return NO_OBJECT;
+
+    timers[timer].inUse = true;
+    timers[timer].running = false;
+    timers[timer].fn = fn;
+    timers[timer].arg = arg;
+    return timer;
+}
+
+// Sets how many ticks a task of this priority runs before preemption hands
+// the cpu to the next ready task of the same priority (1 by default, before
+// startRtos)
+// A task of higher priority that gets ready still preempts at once
+bool setQuantum(uint8_t priority, uint8_t ticks)
+{
+    if (priority >= NUM_PRIORITIES || !ticks)
+        return false;
+
+    quantum[priority] = ticks;
+    return true;
+}
+
+// Sets a function the idle task calls each time before it sleeps (before
+// startRtos), for background work that should only use spare cycles
+void setIdleHook(_fn hook)
+{
+    idleHook = hook;
+}
+
+// Reserves count message blocks for block queues (before startRtos)
+bool initBlockPool(uint8_t count)
+{
+    uint8_t i;
+
+    if (blockCount || !count || count > MAX_BLOCKS)
+        return false;
+
+    blockBase = mallocFromHeap(count * BLOCK_SIZE);
+    if (!blockBase)
+        return false;
+
+    blockCount = count;
+    for (i = 0; i < count; i++)
+    {
+        blockOwner[i] = BLOCK_FREE;
+        blockSharer[i] = NO_TASK;
     }
+    return true;
+}
+
+// Selects FIFO (default) or priority-ordered wake-up, only while nobody waits
+bool setMutexPriorityOrder(uint8_t mutex, bool on)
+{
+    bool ok = (mutex < MAX_MUTEXES && mutexes[mutex].inUse && !mutexes[mutex].queueSize);
+    if (ok)
+        mutexes[mutex].priorityOrder = on;
     return ok;
 }
 
-// REQUIRED: modify this function to restart a thread
-void restartThread(_fn fn)
+bool setSemaphorePriorityOrder(uint8_t semaphore, bool on)
 {
-    __asm("    SVC #8");
+    bool ok = (semaphore < MAX_SEMAPHORES && semaphores[semaphore].inUse && !semaphores[semaphore].queueSize);
+    if (ok)
+        semaphores[semaphore].priorityOrder = on;
+    return ok;
 }
 
-// REQUIRED: modify this function to stop a thread
-// REQUIRED: remove any pending semaphore waiting, unlock any mutexes
-void stopThread(_fn fn)
+// Wait list key of a task, its priority if the object wakes by priority
+uint8_t getWaitKey(bool priorityOrder, uint8_t task)
 {
-    __asm("    SVC #10");
+    return priorityOrder ? tcb[task].priority : 0;
 }
 
-// REQUIRED: modify this function to set a thread priority
-void setThreadPriority(_fn fn, uint8_t priority)
+bool isMutex(uint8_t mutex)
 {
-    __asm("    SVC #12");
+    return mutex < MAX_MUTEXES && mutexes[mutex].inUse;
 }
 
-uint32_t getPid(const char name[])
+bool isSemaphore(uint8_t semaphore)
 {
-    __asm("    SVC #7");
+    return semaphore < MAX_SEMAPHORES && semaphores[semaphore].inUse;
 }
 
-void getMutexInfo(IPCS_MUT_DATA *mutex_data, uint8_t mutex)
+bool isEventGroup(uint8_t group)
 {
-    __asm("    SVC #13");
+    return group < MAX_EVENT_GROUPS && eventGroups[group].inUse;
 }
 
-void getSemaphoreInfo(IPCS_SEM_DATA *sem_data, uint8_t semaphore)
+bool isQueue(uint8_t q)
 {
-    __asm("    SVC #14");
+    return q < MAX_QUEUES && queues[q].inUse;
 }
 
-void getTcb(PS_DATA *ps_data)
+bool isCondVar(uint8_t cv)
 {
-    __asm("    SVC #16");
+    return cv < MAX_COND_VARS && condVars[cv].inUse;
 }
 
-// REQUIRED: modify this function to yield execution back to scheduler using pendsv
-void yield(void)
+bool isRwLock(uint8_t rw)
 {
-    __asm("    SVC #1");
+    return rw < MAX_RW_LOCKS && rwLocks[rw].inUse;
 }
 
-// REQUIRED: modify this function to support 1ms system timer
-// execution yielded back to scheduler until time elapses using pendsv
-void sleep(uint32_t tick)
+bool isTimer(uint8_t timer)
 {
-    __asm("    SVC #2");
+    return timer < MAX_TIMERS && timers[timer].inUse;
 }
 
-// REQUIRED: modify this function to lock a mutex using pendsv
-void lock(int8_t mutex)
+bool isPool(uint8_t p)
 {
-    __asm("    SVC #3");
+    return p < MAX_POOLS && pools[p].inUse;
 }
 
-// REQUIRED: modify this function to unlock a mutex using pendsv
-void unlock(int8_t mutex)
+// A handle is valid while its record holds a task of the same generation
+bool isThread(uint32_t thread)
 {
-    __asm("    SVC #4");
+    uint8_t task = thread & 0xFF;
+
+    return thread <= 0xFFFF && task < MAX_TASKS && tcb[task].state != STATE_INVALID
+            && tcb[task].generation == thread >> 8;
 }
 
-// REQUIRED: modify this function to wait a semaphore using pendsv
-void wait(int8_t semaphore)
+_thread getHandle(uint8_t task)
 {
-    __asm("    SVC #5");
+    return (tcb[task].generation << 8) | task;
 }
 
-// REQUIRED: modify this function to signal a semaphore is available using pendsv
-void post(int8_t semaphore)
+uint8_t hashName(const char name[])
 {
-    __asm("    SVC #6");
+    uint8_t hash = 0;
+
+    while (*name)
+        hash = hash * 31 + *name++;
+    return hash & (NAME_BUCKETS - 1);
 }
 
-// REQUIRED: modify this function to add support for the system timer
-// REQUIRED: in preemptive code, add code to request task switch
-void systickIsr(void)
+bool holdsRwLock(uint8_t rw, uint8_t task)
+{
+    return (rwLocks[rw].writer && rwLocks[rw].writerTask == task)
+            || (rwLocks[rw].readerMask & (1 << task));
+}
+
+// Highest priority (lowest number) among priority and the tasks of a wait list
+uint8_t getWaitersPriority(waitList *list, uint8_t priority)
 {
     uint8_t task;
-    for (task = 0; task < taskCount; task++)
-    {
-        if (tcb[task].state == STATE_DELAYED)
-        {
-            tcb[task].ticks--;
 
-            if (!tcb[task].ticks)
-                tcb[task].state = STATE_READY;
+    for (task = list->head; task != NO_TASK; task = tcb[task].next)
+        if (tcb[task].currentPriority < priority)
+            priority = tcb[task].currentPriority;
+    return priority;
+}
+
+// Priority a task runs at: its own or, with priority inheritance, that of the
+// highest priority task waiting on a mutex or rw lock it holds
+uint8_t getInheritedPriority(uint8_t task)
+{
+    uint8_t priority = tcb[task].priority;
+    uint8_t i;
+
+    if (!priorityInheritance)
+        return priority;
+
+    for (i = 0; i < MAX_MUTEXES; i++)
+        if (mutexes[i].inUse && mutexes[i].lock && mutexes[i].lockedBy == task)
+            priority = getWaitersPriority(&mutexes[i].waiters, priority);
+    for (i = 0; i < MAX_RW_LOCKS; i++)
+        if (rwLocks[i].inUse && holdsRwLock(i, task))
+        {
+            priority = getWaitersPriority(&rwLocks[i].readWaiters, priority);
+            priority = getWaitersPriority(&rwLocks[i].writeWaiters, priority);
         }
-    }
+    return priority;
+}
 
-    if (preemption)
+// Recomputes the priority of a task after a lock or wait changed, and passes
+// a change on along the chain of mutex and write holders it waits for
+// (readers a writer waits for are raised, but their own waits not followed)
+void updatePriority(uint8_t task)
+{
+    uint8_t steps = 0;
+    uint8_t priority;
+    uint8_t rw;
+    uint8_t i;
+
+    while (task < MAX_TASKS && steps++ < MAX_TASKS)
     {
-        NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+        priority = getInheritedPriority(task);
+        if (priority == tcb[task].currentPriority)
+            return;
+        tcb[task].currentPriority = priority;
+
+        rw = tcb[task].rwLock;
+        if (tcb[task].state == STATE_BLOCKED_MUTEX)
+            task = mutexes[tcb[task].mutex].lockedBy;
+        else if ((tcb[task].state == STATE_BLOCKED_READ || tcb[task].state == STATE_BLOCKED_WRITE)
+                && rwLocks[rw].writer)
+            task = rwLocks[rw].writerTask;
+        else
+        {
+            if (tcb[task].state == STATE_BLOCKED_WRITE)
+                for (i = 0; i < MAX_TASKS; i++)
+                    if (rwLocks[rw].readerMask & (1 << i))
+                        tcb[i].currentPriority = getInheritedPriority(i);
+            task = NO_TASK;
+        }
     }
+}
 
-    // togglePinValue(PORTD,1);
-    // NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PENDSTCLR;
+// Updates every task holding a rw lock
+void updateRwPriorities(uint8_t rw)
+{
+    uint8_t task;
+
+    if (rwLocks[rw].writer)
+        updatePriority(rwLocks[rw].writerTask);
+    for (task = 0; task < MAX_TASKS; task++)
+        if (rwLocks[rw].readerMask & (1 << task))
+            updatePriority(task);
 }
 
-// REQUIRED: in coop and preemptive, modify this function to add support for task switching
-// REQUIRED: process UNRUN and READY tasks differently
-void pendSvIsr(void)
+// Index of the message block at p, NO_OBJECT if p is not one
+uint8_t getBlock(uint8_t *p)
 {
-    strRegs();
+    uint32_t offset = p - blockBase;
 
-    tcb[taskCurrent].sp = (void *)getPsp();
-    taskCurrent = rtosScheduler();
-    setPsp((uint32_t)tcb[taskCurrent].sp);
-    applySramSrdMasks(tcb[taskCurrent].srd);
+    if (!blockCount || p < blockBase || offset % BLOCK_SIZE || offset / BLOCK_SIZE >= blockCount)
+        return NO_OBJECT;
+    return offset / BLOCK_SIZE;
+}
 
-    if (tcb[taskCurrent].state == STATE_READY)
-        ldrRegs();
-    else
+// Adds or removes a block's subregion in a task's SRD mask
+void grantBlock(uint8_t block, uint8_t task, bool on)
+{
+    uint8_t mask[NUM_SRAM_REGIONS] = {0, 0, 0, 0};
+    uint8_t i;
+
+    if (task >= MAX_TASKS)
+        return;
+
+    generateSramSrdMasks(mask, blockBase + (block + 1) * BLOCK_SIZE - 1, BLOCK_SIZE);
+    for (i = 0; i < NUM_SRAM_REGIONS; i++)
     {
-        tcb[taskCurrent].state = STATE_READY;
-        runProgram(tcb[taskCurrent].pid);
+        if (on)
+            tcb[task].srd[i] |= mask[i];
+        else
+            tcb[task].srd[i] &= ~mask[i];
     }
 
+    if (task == taskCurrent)
+        applySramSrdMasks(tcb[taskCurrent].srd);
 }
 
-// REQUIRED: modify this function to add support for the service call
-// REQUIRED: in preemptive code, add code to handle synchronization primitives
-void svCallIsr(void)
+// Moves a block from its owner to task (or BLOCK_FREE/QUEUED)
+void setBlockOwner(uint8_t block, uint8_t task)
 {
-    uint32_t svc_num = *(uint32_t *)(*(getPsp() + 6) - 2) & 0xFF;
+    grantBlock(block, blockOwner[block], false);
+    blockOwner[block] = task;
+    grantBlock(block, task, true);
+}
 
-    switch (svc_num)
-    {
-        case 1: // yield
-        {
-            NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
-            break;
-        }
-        case 2: // sleep
-        {
-            uint32_t ticks = *getPsp();
+// Returns a block to the pool, the task it was shared with loses access too
+void returnBlock(uint8_t block)
+{
+    grantBlock(block, blockSharer[block], false);
+    blockSharer[block] = NO_TASK;
+    setBlockOwner(block, BLOCK_FREE);
+}
 
-            tcb[taskCurrent].state = STATE_DELAYED;
-            tcb[taskCurrent].ticks = ticks;
-            NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
-            break;
-        }
-        case 3: // lock
+// Returns the blocks task owns to the pool, blocks shared with it stay with
+// their owner
+void releaseBlocks(uint8_t task)
+{
+    uint8_t block;
+
+    for (block = 0; block < blockCount; block++)
+    {
+        if (blockOwner[block] == task)
+            returnBlock(block);
+        else if (blockSharer[block] == task)
+            blockSharer[block] = NO_TASK;
+    }
+}
+
+void copyMessage(uint8_t to[], const uint8_t from[], uint8_t size)
+{
+    while (size--)
+        *to++ = *from++;
+}
+
+// Block a block queue message points to
+uint8_t getMessageBlock(const uint8_t msg[])
+{
+    uint8_t *block;
+
+    copyMessage((uint8_t *)&block, msg, sizeof(block));
+    return getBlock(block);
+}
+
+// Flags of a group that satisfy a wait, 0 if the wait is not satisfied
+uint32_t matchFlags(uint32_t flags, uint32_t mask, uint8_t mode)
+{
+    flags &= mask;
+    if ((mode & FLAGS_ALL) && flags != mask)
+        return 0;
+    return flags;
+}
+
+// Makes a blocked task ready, a timed or flag wait returns result
+void wakeWaiter(uint8_t task, uint32_t result)
+{
+    if (tcb[task].waitResult)
+        *tcb[task].waitResult = result;
+    tcb[task].waitResult = 0;
+    tcb[task].ticks = 0;
+    tcb[task].state = STATE_READY;
+    traceEvent(TRACE_READY, task);
+    if (tcb[task].currentPriority < tcb[taskCurrent].currentPriority)
+        higherReady = true;
+}
+
+// Hands a rw lock on after a holder let go: to the first writer if nobody
+// holds it, to every waiting reader if no writer waits, and with readersFirst
+// (after a write) to the readers that waited through it before any writer
+void passRwLock(uint8_t rw, bool readersFirst)
+{
+    uint8_t task;
+
+    if (rwLocks[rw].writer)
+        return;
+
+    if (!readersFirst && !rwLocks[rw].readers)
+    {
+        task = takeWaiter(&rwLocks[rw].writeWaiters);
+        if (task != NO_TASK)
         {
-            int8_t mutex = *getPsp();
-            // if mutex free
-            if (mutexes[mutex].lock == false)
-            {
-                // lock it man
-                mutexes[mutex].lock = true;
-                // specify who locked it
-                mutexes[mutex].lockedBy = taskCurrent;
-            }
-            else
-            {
-                // add task to mutex queue
-                mutexes[mutex].processQueue[mutexes[mutex].queueSize] = taskCurrent;
-                // inc waiting list
-                mutexes[mutex].queueSize++;
-                // state -> blocked mutex
-                tcb[taskCurrent].state = STATE_BLOCKED_MUTEX;
-                // pendsv
-                NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
-            }
-            break;
+            rwLocks[rw].writeQueueSize--;
+            rwLocks[rw].writer = true;
+            rwLocks[rw].writerTask = task;
+            wakeWaiter(task, true);
+            updateRwPriorities(rw);
+            return;
         }
-        case 4: // unlock
-        {
-            int8_t mutex = *getPsp();
-            // if you locked it
-            if (mutexes[mutex].lockedBy == taskCurrent)
-            {
-                // unlock it man
-                mutexes[mutex].lock = false;
+    }
 
-                // if people are waiting (waitors)
-                if (mutexes[mutex].queueSize)
-                {
-                    uint8_t ager = 0;
-                    // mark next one as ready
-                    tcb[mutexes[mutex].processQueue[ager]].state = STATE_READY;
-                    mutexes[mutex].lockedBy = mutexes[mutex].processQueue[0];
-                    // decrement wait count, age all waitors
-                    mutexes[mutex].queueSize--;
-                    for (ager = 0; ager < (MAX_MUTEX_QUEUE_SIZE - 1); ager++)
-                    {
-                        mutexes[mutex].processQueue[ager] = mutexes[mutex].processQueue[ager + 1];
-                    }
-                    mutexes[mutex].lock = true;
-                }
-            }
-            break;
-        }
-        case 5: // wait
+    if (readersFirst || !rwLocks[rw].writeQueueSize)
+    {
+        while ((task = takeWaiter(&rwLocks[rw].readWaiters)) != NO_TASK)
         {
-            int8_t semaphore = *getPsp();
-            // decrement count number if there is a count
-            if (semaphores[semaphore].count > 0)
-            {
-                semaphores[semaphore].count--;
-            }
-            else
-            {
-                // place task in queue
-                semaphores[semaphore].processQueue[semaphores[semaphore].queueSize] = taskCurrent;
-                // increment queue count
-                semaphores[semaphore].queueSize++;
-                // state goes to wait
-                tcb[taskCurrent].state = STATE_BLOCKED_SEMAPHORE;
-
-                tcb[taskCurrent].semaphore = semaphore;
-                // switch task
-                NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
-            }
-            break;
+            rwLocks[rw].readQueueSize--;
+            rwLocks[rw].readers++;
+            rwLocks[rw].readerMask |= 1 << task;
+            wakeWaiter(task, true);
         }
-        case 6: // post
-        {
-            int8_t semaphore = *getPsp();
+        updateRwPriorities(rw);
+    }
+}
+
+// Links a timer into the running list behind every timer due at the same time
+void addTimer(uint8_t timer)
+{
+    uint8_t *link = &timerHead;
+
+    while (*link != NO_OBJECT && (int32_t)(timers[*link].expiry - timers[timer].expiry) <= 0)
+        link = &timers[*link].next;
+
+    timers[timer].next = *link;
+    *link = timer;
+    timers[timer].running = true;
+}
+
+void removeTimer(uint8_t timer)
+{
+    uint8_t *link = &timerHead;
 
-            semaphores[semaphore].count++;
-            // if someone is in the queue
-            if (semaphores[semaphore].queueSize)
+    while (*link != timer)
+        link = &timers[*link].next;
+
+    *link = timers[timer].next;
+    timers[timer].running = false;
+}
+
+// Wakes the tasks whose usleep ran out and sets the alarm for the next one
+// An alarm that is already behind now_us() when it is set is handled here
+// again, so a short usleep never waits for a match that will not come
+void wakeMicroSleepers(void)
+{
+    uint64_t now;
+    int32_t left;
+    int32_t next;
+    bool waiting;
+    uint8_t task;
+
+    do
+    {
+        now = now_us();
+        next = INT32_MAX;
+        waiting = false;
+        for (task = 0; task < MAX_TASKS; task++)
+        {
+            if (tcb[task].state == STATE_DELAYED_US)
             {
-                uint8_t ager = 0;
-                // set task to ready
-                tcb[semaphores[semaphore].processQueue[ager]].state = STATE_READY;
-                // decrement queue count
-                semaphores[semaphore].queueSize--;
-                // delete old waitor in list
-                for (ager = 0; ager < (MAX_SEMAPHORE_QUEUE_SIZE - 1); ager++)
+                left = (int32_t)(tcb[task].ticks - (uint32_t)now);
+                if (left <= 0)
+                    wakeWaiter(task, 0);
+                else
                 {
-                    semaphores[semaphore].processQueue[ager] = semaphores[semaphore].processQueue[ager + 1];
+                    waiting = true;
+                    if (left < next)
+                        next = left;
                 }
-                // decrement count
-                semaphores[semaphore].count--;
             }
-            break;
         }
-        case 7: // getPid
+
+        if (!waiting)
         {
-            uint8_t task = 0;
-            bool ok = false;
+            microAlarm = 0;
+            stopMicroAlarm();
+            return;
+        }
+        microAlarm = now + next;
+    } while (!setMicroAlarm(microAlarm));
+}
 
-            while(!ok && task < MAX_TASKS)
-            {
-                ok = (stringsEqual(tcb[task].name, (char *)*getPsp()));
-                if (!ok)
-                    task++;
-            }
+// Unlinks a blocked task from the wait list of its object
+void leaveWaitList(uint8_t task)
+{
+    if (tcb[task].state == STATE_BLOCKED_SEND)
+        removeWaiter(&queues[tcb[task].queue].senders, task);
+    if (tcb[task].state == STATE_BLOCKED_RECEIVE)
+        removeWaiter(&queues[tcb[task].queue].receivers, task);
+    if (tcb[task].state == STATE_BLOCKED_MUTEX)
+    {
+        removeWaiter(&mutexes[tcb[task].mutex].waiters, task);
+        mutexes[tcb[task].mutex].queueSize--;
+        updatePriority(mutexes[tcb[task].mutex].lockedBy);
+    }
+    if (tcb[task].state == STATE_BLOCKED_SEMAPHORE)
+    {
+        removeWaiter(&semaphores[tcb[task].semaphore].waiters, task);
+        semaphores[tcb[task].semaphore].queueSize--;
+    }
+    if (tcb[task].state == STATE_BLOCKED_FLAGS)
+    {
+        removeWaiter(&eventGroups[tcb[task].group].waiters, task);
+        eventGroups[tcb[task].group].queueSize--;
+    }
+    if (tcb[task].state == STATE_BLOCKED_COND)
+    {
+        removeWaiter(&condVars[tcb[task].condVar].waiters, task);
+        condVars[tcb[task].condVar].queueSize--;
+    }
+    if (tcb[task].state == STATE_BLOCKED_READ)
+    {
+        removeWaiter(&rwLocks[tcb[task].rwLock].readWaiters, task);
+        rwLocks[tcb[task].rwLock].readQueueSize--;
+        updateRwPriorities(tcb[task].rwLock);
+    }
+    if (tcb[task].state == STATE_BLOCKED_WRITE)
+    {
+        // readers held back by this writer may go in now
+        removeWaiter(&rwLocks[tcb[task].rwLock].writeWaiters, task);
+        rwLocks[tcb[task].rwLock].writeQueueSize--;
+        passRwLock(tcb[task].rwLock, false);
+        updateRwPriorities(tcb[task].rwLock);
+    }
+    tcb[task].waitResult = 0;
+    tcb[task].ticks = 0;
+}
 
-            if (ok)
-                strPid((uint32_t)tcb[task].pid);
+// Takes a task whose timed wait ran out off the wait list, the wait
+// returns the false (or 0) stacked when it blocked
+void expireWaiter(uint8_t task)
+{
+    leaveWaitList(task);
+    tcb[task].state = STATE_READY;
+    traceEvent(TRACE_READY, task);
+}
 
-            break;
-        }
-        case 8: // restart thread
-        {
-            uint8_t task = 0;
-            bool ok = false;
+// Blocks the current task on a mutex, ticks > 0 bounds the wait
+void blockOnMutex(uint8_t mutex, uint32_t ticks)
+{
+    traceEvent(TRACE_MTX_BLOCK, mutex);
+    addWaiter(&mutexes[mutex].waiters, taskCurrent,
+              getWaitKey(mutexes[mutex].priorityOrder, taskCurrent));
+    mutexes[mutex].queueSize++;
+    tcb[taskCurrent].state = STATE_BLOCKED_MUTEX;
+    tcb[taskCurrent].mutex = mutex;
+    tcb[taskCurrent].ticks = ticks;
+    updatePriority(mutexes[mutex].lockedBy);
+    NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+}
 
-            while(!ok && task < MAX_TASKS)
-            {
-                ok = (tcb[task].pid == (void *)*getPsp());
-                if (!ok)
-                    task++;
-            }
+// Blocks the current task on a semaphore, ticks > 0 bounds the wait
+void blockOnSemaphore(uint8_t semaphore, uint32_t ticks)
+{
+    traceEvent(TRACE_SEM_BLOCK, semaphore);
+    addWaiter(&semaphores[semaphore].waiters, taskCurrent,
+              getWaitKey(semaphores[semaphore].priorityOrder, taskCurrent));
+    semaphores[semaphore].queueSize++;
+    tcb[taskCurrent].state = STATE_BLOCKED_SEMAPHORE;
+    tcb[taskCurrent].semaphore = semaphore;
+    tcb[taskCurrent].ticks = ticks;
+    NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+}
 
-            if (ok)
-            {
-                // tcb[task].sp = tcb[task].spInit;
-                tcb[task].state = STATE_READY;
-            }
+// Blocks the current task on an event group, ticks > 0 bounds the wait
+void blockOnFlags(uint8_t group, uint32_t mask, uint8_t mode, uint32_t ticks)
+{
+    traceEvent(TRACE_FLG_BLOCK, group);
+    addWaiter(&eventGroups[group].waiters, taskCurrent, 0);
+    eventGroups[group].queueSize++;
+    tcb[taskCurrent].state = STATE_BLOCKED_FLAGS;
+    tcb[taskCurrent].group = group;
+    tcb[taskCurrent].flagMask = mask;
+    tcb[taskCurrent].flagMode = mode;
+    tcb[taskCurrent].ticks = ticks;
+    NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+}
 
-            break;
-        }
-        case 9: // preempt
-        {
-            preemption = *getPsp();
-            break;
-        }
-        case 10: // stop thread
-        {
-            uint8_t task = 0;
-            bool ok = false;
+// Blocks the current task on a condition variable, mutex is the one it
+// released and gets back before running again
+void blockOnCondVar(uint8_t cv, uint8_t mutex)
+{
+    addWaiter(&condVars[cv].waiters, taskCurrent, 0);
+    condVars[cv].queueSize++;
+    tcb[taskCurrent].state = STATE_BLOCKED_COND;
+    tcb[taskCurrent].condVar = cv;
+    tcb[taskCurrent].mutex = mutex;
+    tcb[taskCurrent].ticks = 0;
+    NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+}
 
-            while(!ok && task < MAX_TASKS)
-            {
-                ok = (tcb[task].pid == (void *)*getPsp());
-                if (!ok)
-                    task++;
-            }
+// Blocks the current task on a rw lock, state is STATE_BLOCKED_READ or _WRITE
+void blockOnRwLock(uint8_t rw, uint8_t state)
+{
+    if (state == STATE_BLOCKED_WRITE)
+    {
+        addWaiter(&rwLocks[rw].writeWaiters, taskCurrent, 0);
+        rwLocks[rw].writeQueueSize++;
+        rwLocks[rw].writeContended++;
+    }
+    else
+    {
+        addWaiter(&rwLocks[rw].readWaiters, taskCurrent, 0);
+        rwLocks[rw].readQueueSize++;
+        rwLocks[rw].readContended++;
+    }
+    tcb[taskCurrent].state = state;
+    tcb[taskCurrent].rwLock = rw;
+    tcb[taskCurrent].ticks = 0;
+    updateRwPriorities(rw);
+    NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+}
 
-            if (tcb[task].state == STATE_BLOCKED_MUTEX)
-            {
-                ok = false;
+// Blocks the current task on a full (send) or empty (receive) queue
+void blockOnQueue(uint8_t q, uint8_t state, uint8_t *msg, bool urgent, uint32_t ticks)
+{
+    addWaiter(state == STATE_BLOCKED_SEND ? &queues[q].senders : &queues[q].receivers,
+              taskCurrent, 0);
+    tcb[taskCurrent].state = state;
+    tcb[taskCurrent].queue = q;
+    tcb[taskCurrent].msg = msg;
+    tcb[taskCurrent].urgent = urgent;
+    tcb[taskCurrent].ticks = ticks;
+    NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+}
 
-                uint8_t queue_index = 0;
-                while (!ok && queue_index < (MAX_MUTEX_QUEUE_SIZE - 1))
-                {
-                    ok = (mutexes[tcb[task].mutex].processQueue[queue_index] == task);
-                    if (!ok)
-                        queue_index++;
-                }
+// Hands a message to the first waiting receiver or stores it, at the back
+// of the ring or at the front if urgent
+// The caller checks there is room (count < depth or a receiver waiting)
+void putMessage(uint8_t q, const uint8_t msg[], bool urgent)
+{
+    uint8_t task = takeWaiter(&queues[q].receivers);
+    uint8_t slot;
 
-                uint8_t ager = queue_index;
-                // decrement wait count, age all waitors
-                mutexes[tcb[task].mutex].queueSize--;
-                for (ager = 0; ager < (MAX_MUTEX_QUEUE_SIZE - 1); ager++)
-                {
-                    mutexes[tcb[task].mutex].processQueue[ager] = mutexes[tcb[task].mutex].processQueue[ager + 1];
-                }
-            }
+    if (task != NO_TASK)
+    {
+        copyMessage(tcb[task].msg, msg, queues[q].msgSize);
+        if (queues[q].blocks)
+            setBlockOwner(getMessageBlock(msg), task);
+        wakeWaiter(task, true);
+        return;
+    }
 
-            if (mutexes[tcb[task].mutex].lockedBy == task)
-            {
-                mutexes[tcb[task].mutex].lock = false;
+    if (urgent)
+    {
+        queues[q].head = (queues[q].head + queues[q].depth - 1) % queues[q].depth;
+        slot = queues[q].head;
+    }
+    else
+        slot = (queues[q].head + queues[q].count) % queues[q].depth;
 
-                // if people are waiting (waitors)
-                if (mutexes[tcb[task].mutex].queueSize)
-                {
-                    uint8_t ager = 0;
-                    // mark next one as ready
-                    tcb[mutexes[tcb[task].mutex].processQueue[ager]].state = STATE_READY;
-                    mutexes[tcb[task].mutex].lockedBy = mutexes[tcb[task].mutex].processQueue[0];
-                    // decrement wait count, age all waitors
-                    mutexes[tcb[task].mutex].queueSize--;
-                    for (ager = 0; ager < (MAX_MUTEX_QUEUE_SIZE - 1); ager++)
-                    {
-                        mutexes[tcb[task].mutex].processQueue[ager] = mutexes[tcb[task].mutex].processQueue[ager + 1];
-                    }
-                    mutexes[tcb[task].mutex].lock = true;
-                }
-            }
+    copyMessage(&queueBuffer[queues[q].buffer + slot * queues[q].msgSize], msg, queues[q].msgSize);
+    if (queues[q].blocks)
+        setBlockOwner(getMessageBlock(msg), BLOCK_QUEUED);
+    queues[q].count++;
+}
 
-            if (tcb[task].state == STATE_BLOCKED_SEMAPHORE)
-            {
-                semaphores[tcb[task].semaphore].count++;
-                // if someone is in the queue
-                if (semaphores[tcb[task].semaphore].queueSize)
-                {
-                    uint8_t ager = 0;
-                    // set task to ready
-                    tcb[semaphores[tcb[task].semaphore].processQueue[ager]].state = STATE_READY;
-                    // decrement queue count
-                    semaphores[tcb[task].semaphore].queueSize--;
-                    // delete old waitor in list
-                    for (ager = 0; ager < (MAX_SEMAPHORE_QUEUE_SIZE - 1); ager++)
-                    {
-                        semaphores[tcb[task].semaphore].processQueue[ager] = semaphores[tcb[task].semaphore].processQueue[ager + 1];
-                    }
-                    // decrement count
-                    semaphores[tcb[task].semaphore].count--;
-                }
-            }
+// Queues the callbacks of the timers that ran out for the work task and
+// restarts the auto-reload ones
+// A timer stays due while the work queue is full and is tried again next tick
+void expireTimers(void)
+{
+    workItem item;
+    uint8_t timer;
 
-            tcb[task].state = STATE_STOPPED;
+    while (timerHead != NO_OBJECT && (int32_t)(tickCount - timers[timerHead].expiry) >= 0
+            && (queues[workQueue].count < queues[workQueue].depth
+            || queues[workQueue].receivers.head != NO_TASK))
+    {
+        timer = timerHead;
+        removeTimer(timer);
+        item.fn = timers[timer].fn;
+        item.arg = timers[timer].arg;
+        putMessage(workQueue, (uint8_t *)&item, false);
 
-            break;
-        }
-        case 11: // reboot
+        if (timers[timer].autoReload)
         {
-            NVIC_APINT_R = NVIC_APINT_VECTKEY | NVIC_APINT_SYSRESETREQ;
-            break;
+            timers[timer].expiry += timers[timer].period;
+            addTimer(timer);
         }
-        case 12: // thread priority
-        {
-            uint8_t task = 0;
-            bool ok = false;
+    }
+}
 
-            while(!ok && task < MAX_TASKS)
-            {
-                ok = (tcb[task].pid == (void *)*getPsp());
-                if (!ok)
-                    task++;
-            }
+// Takes the oldest message for task and lets the first waiting sender in
+void getMessage(uint8_t q, uint8_t msg[], uint8_t receiver)
+{
+    uint8_t *slot = &queueBuffer[queues[q].buffer + queues[q].head * queues[q].msgSize];
+    uint8_t task;
 
-            if (ok)
-            {
-                tcb[task].priority = *(getPsp() + 1);
-            }
+    copyMessage(msg, slot, queues[q].msgSize);
+    if (queues[q].blocks)
+        setBlockOwner(getMessageBlock(slot), receiver);
+    queues[q].head = (queues[q].head + 1) % queues[q].depth;
+    queues[q].count--;
 
-            break;
-        }
-        case 13: // get mutex data
+    task = takeWaiter(&queues[q].senders);
+    if (task != NO_TASK)
+    {
+        putMessage(q, tcb[task].msg, tcb[task].urgent);
+        wakeWaiter(task, true);
+    }
+}
+
+// Sets flags and wakes every waiter they satisfy in one pass, the flags
+// those waiters asked to clear are cleared once all have been checked
+void raiseFlags(uint8_t group, uint32_t flags)
+{
+    uint32_t clear = 0;
+    uint32_t match;
+    uint8_t task;
+    uint8_t next;
+
+    eventGroups[group].flags |= flags;
+    traceEvent(TRACE_FLG_SET, group);
+
+    task = eventGroups[group].waiters.head;
+    while (task != NO_TASK)
+    {
+        next = tcb[task].next;
+        match = matchFlags(eventGroups[group].flags, tcb[task].flagMask, tcb[task].flagMode);
+        if (match)
         {
-            uint8_t mutex_queue = 0;
+            if (tcb[task].flagMode & FLAGS_CLEAR)
+                clear |= tcb[task].flagMask;
+            removeWaiter(&eventGroups[group].waiters, task);
+            eventGroups[group].queueSize--;
+            wakeWaiter(task, match);
+        }
+        task = next;
+    }
 
-            uint8_t mutex = *(getPsp() + 1);
+    eventGroups[group].flags &= ~clear;
+}
 
-            // IPCS_MUT_DATA *mut_data = *getPsp();
+// Gives the count to the first waiter, or keeps it if nobody waits
+void postSemaphore(uint8_t semaphore)
+{
+    uint8_t task;
 
-            // CopyStrings(tcb[mutexes[mutex].lockedBy].name, mutex->lockedByName);
+    traceEvent(TRACE_SEM_POST, semaphore);
+    task = takeWaiter(&semaphores[semaphore].waiters);
+    if (task != NO_TASK)
+    {
+        semaphores[semaphore].queueSize--;
+        wakeWaiter(task, true);
+    }
+    else
+        semaphores[semaphore].count++;
+}
 
-            /*
-            while (mutex_queue != mutexes[mutex].queueSize)
-            {
+// Returns the deque of a pool worker, NO_OBJECT for any other task (or
+// NO_TASK)
+uint8_t getJobDeque(uint8_t task)
+{
+    uint8_t deque;
 
-            }
-            */
+    if (task == NO_TASK)
+        return NO_OBJECT;
 
-            break;
-        }
-        case 14: // get sem data
-        {
+    for (deque = 0; deque < jobDequesUsed; deque++)
+        if (jobDeques[deque].worker == getHandle(task))
+            return deque;
+    return NO_OBJECT;
+}
 
+// Adds a job to the back of the next deque of a pool with room and wakes an
+// idle worker, a worker of the pool adds to its own deque first, so the jobs
+// a job splits into stay with it unless another worker runs out
+// The deque of a destroyed worker gets no more jobs, the others steal the
+// ones left on it
+// Returns false if every deque of the pool is full
+bool putJob(uint8_t p, _workFn fn, uint32_t arg, uint8_t task)
+{
+    jobDeque *deque;
+    uint8_t own = getJobDeque(task);
+    uint8_t worker;
+    uint8_t i;
 
-            break;
-        }
-        case 15: // sched
+    if (own != NO_OBJECT && jobDeques[own].pool == p && jobDeques[own].count < POOL_DEQUE_DEPTH)
+        deque = &jobDeques[own];
+    else
+    {
+        for (i = 0; i < pools[p].workers; i++)
         {
-            priorityScheduler = *getPsp();
-
-            break;
+            worker = (pools[p].next + i) % pools[p].workers;
+            if (jobDeques[pools[p].first + worker].count < POOL_DEQUE_DEPTH
+                    && isThread(jobDeques[pools[p].first + worker].worker))
+                break;
         }
-        case 16: // ps
-        {
-            uint8_t task = 0;
-            PS_DATA *ps_data = (PS_DATA*)getPsp();
+        if (i == pools[p].workers)
+            return false;
+        deque = &jobDeques[pools[p].first + worker];
+        pools[p].next = (worker + 1) % pools[p].workers;
+    }
 
-            while(task < taskCount)
-             {
-                 CopyStrings(tcb[task].name, (ps_data->name[task]));
-                 ps_data->pid[task] = (uint32_t)tcb[task].pid;
-                 task++;
-             }
+    deque->jobs[(deque->head + deque->count) % POOL_DEQUE_DEPTH].fn = fn;
+    deque->jobs[(deque->head + deque->count) % POOL_DEQUE_DEPTH].arg = arg;
+    deque->count++;
 
-            break;
-        }
+    // the count of the idle semaphore stays 0, a post only wakes a worker
+    if (semaphores[pools[p].idle].waiters.head != NO_TASK)
+        postSemaphore(pools[p].idle);
+    return true;
+}
+
+// Takes the oldest job of the deque of a worker or, if that is empty, steals
+// the newest job of the fullest other deque of its pool
+// Returns false if the pool has no job queued
+bool takeJob(uint8_t own, workItem *job)
+{
+    uint8_t p = jobDeques[own].pool;
+    uint8_t victim = own;
+    uint8_t deque;
+
+    if (jobDeques[own].count)
+    {
+        *job = jobDeques[own].jobs[jobDeques[own].head];
+        jobDeques[own].head = (jobDeques[own].head + 1) % POOL_DEQUE_DEPTH;
+        jobDeques[own].count--;
+        return true;
+    }
+
+    for (deque = pools[p].first; deque < pools[p].first + pools[p].workers; deque++)
+        if (jobDeques[deque].count > jobDeques[victim].count)
+            victim = deque;
+
+    if (victim == own)
+        return false;
+
+    jobDeques[victim].count--;
+    *job = jobDeques[victim].jobs[(jobDeques[victim].head + jobDeques[victim].count) % POOL_DEQUE_DEPTH];
+    return true;
+}
+
+// Unlocks a mutex and hands it to the first waiter, if any
+void releaseMutex(uint8_t mutex)
+{
+    uint8_t owner = mutexes[mutex].lockedBy;
+    uint8_t task;
+
+    mutexes[mutex].lock = false;
+    traceEvent(TRACE_MTX_UNLOCK, mutex);
+
+    task = takeWaiter(&mutexes[mutex].waiters);
+    if (task != NO_TASK)
+    {
+        mutexes[mutex].queueSize--;
+        mutexes[mutex].lock = true;
+        mutexes[mutex].lockedBy = task;
+        wakeWaiter(task, true);
+        updatePriority(task);
+    }
+    updatePriority(owner);
+}
+
+// Drops the hold a task has on a rw lock and passes the lock on
+void releaseRwLock(uint8_t rw, uint8_t task)
+{
+    if (rwLocks[rw].writer && rwLocks[rw].writerTask == task)
+    {
+        rwLocks[rw].writer = false;
+        rwLocks[rw].writerTask = NO_TASK;
+        passRwLock(rw, rwLocks[rw].readWaiters.head != NO_TASK);
+    }
+    else
+    {
+        rwLocks[rw].readers--;
+        rwLocks[rw].readerMask &= ~(1 << task);
+        passRwLock(rw, false);
+    }
+    updatePriority(task);
+}
+
+// Takes a task off the wait list it is on and hands the mutexes and rw locks
+// it holds to their next waiters, for stopThread and destroyThread
+void releaseThread(uint8_t task)
+{
+    uint8_t i;
+
+    leaveWaitList(task);
+
+    for (i = 0; i < MAX_MUTEXES; i++)
+        if (mutexes[i].inUse && mutexes[i].lock && mutexes[i].lockedBy == task)
+            releaseMutex(i);
+
+    for (i = 0; i < MAX_RW_LOCKS; i++)
+        if (rwLocks[i].inUse && holdsRwLock(i, task))
+            releaseRwLock(i, task);
+}
+
+// Ends a thread for good: what releaseThread and releaseBlocks give back,
+// its name and its stack
+void removeThread(uint8_t task)
+{
+    uint8_t *link;
+
+    releaseThread(task);
+    releaseBlocks(task);
+
+    link = &nameIndex[hashName(tcb[task].name)];
+    while (*link != task)
+        link = &tcb[*link].nameNext;
+    *link = tcb[task].nameNext;
+
+    // the generation stays, so the handle no longer matches the record
+    freeToHeap(tcb[task].spInit);
+    tcb[task].state = STATE_INVALID;
+    tcb[task].pid = 0;
+    taskCount--;
+}
+
+// Hands the first waiter of a condition variable its mutex if it is free,
+// or queues it on the mutex, so a broadcast wakes the waiters one at a time
+// Returns false if nobody waits
+bool signalCondVar(uint8_t cv)
+{
+    uint8_t task = takeWaiter(&condVars[cv].waiters);
+    uint8_t mutex;
+
+    if (task == NO_TASK)
+        return false;
+
+    condVars[cv].queueSize--;
+    mutex = tcb[task].mutex;
+    if (!mutexes[mutex].lock)
+    {
+        mutexes[mutex].lock = true;
+        mutexes[mutex].lockedBy = task;
+        wakeWaiter(task, true);
+    }
+    else
+    {
+        addWaiter(&mutexes[mutex].waiters, task, getWaitKey(mutexes[mutex].priorityOrder, task));
+        mutexes[mutex].queueSize++;
+        tcb[task].state = STATE_BLOCKED_MUTEX;
+        updatePriority(mutexes[mutex].lockedBy);
+    }
+    return true;
+}
+
+// REQUIRED: initialize systick for 1ms system timer
+void initRtos(void)
+{
+    uint8_t i;
+    // no tasks running
+    taskCount = 0;
+    // clear out tcb records
+    for (i = 0; i < MAX_TASKS; i++)
+    {
+        tcb[i].state = STATE_INVALID;
+        tcb[i].pid = 0;
+        tcb[i].waitResult = 0;
+    }
+    for (i = 0; i < NAME_BUCKETS; i++)
+        nameIndex[i] = NO_TASK;
+
+    // the idle task takes the first (just cleared) record, rtosScheduler falls
+    // back on it when nothing else is ready, so nothing can run without it
+    initCycleCounter();
+    if (createThread(idleTask, "Idle", NUM_PRIORITIES - 1, IDLE_STACK_SIZE) == NO_THREAD)
+    {
+        LOG("Could not create the idle task\n");
+        while (true);
     }
+    taskIdle = 0;
+
+    // PendSV only switches tasks once every other handler is done
+    NVIC_SYS_PRI2_R = (NVIC_SYS_PRI2_R & ~NVIC_SYS_PRI2_SVC_M) | (KERNEL_PRIORITY << 24);
+    NVIC_SYS_PRI3_R = (NVIC_SYS_PRI3_R & ~(NVIC_SYS_PRI3_TICK_M | NVIC_SYS_PRI3_PENDSV_M))
+                    | (KERNEL_PRIORITY << 24) | (PENDSV_PRIORITY << 16);
+
+    NVIC_ST_RELOAD_R = (BOARD_CLOCK_HZ / 1000) - 1; // 1 kHz
+                      // clock source        enable int           enable systick
+    NVIC_ST_CTRL_R |= NVIC_ST_CTRL_CLK_SRC | NVIC_ST_CTRL_INTEN | NVIC_ST_CTRL_ENABLE;
+
+    // now_us() and the compare interrupt behind usleep()
+    initMicroTimer();
+
+    initTrace();
+}
+
+// REQUIRED: Implement prioritization to NUM_PRIORITIES
+// The idle task is left out of both rotations and only runs when no other
+// task is ready, so it never sleeps in WFI while there is work
+uint8_t rtosScheduler(void)
+{
+    bool ok;
+    uint8_t tries = 0;
+    static uint8_t task = 0xFF;
+    static uint8_t last_task[NUM_PRIORITIES] = {0, 0, 0, 0, 0, 0, 0, 0};
+    ok = false;
+
+    if (priorityScheduler)
+    {
+        uint8_t highest_priority = 0;
+        uint8_t start = (last_task[highest_priority] + 1) % MAX_TASKS;
+        task = start;
+
+        while (!ok)
+        {
+            ok = (task != taskIdle && tcb[task].currentPriority == highest_priority
+                    && (tcb[task].state == STATE_READY || tcb[task].state == STATE_UNRUN));
+            if (!ok)
+            {
+                task++;
+                if (task >= MAX_TASKS)
+                {
+                    task = 0;
+                }
+                if (task == start)
+                {
+                    highest_priority++;
+                    if (highest_priority >= NUM_PRIORITIES)
+                        return taskIdle;
+                    start = (last_task[highest_priority] + 1) % MAX_TASKS;
+                    task = start;
+                }
+            }
+        }
+        last_task[highest_priority] = task;
+        return task;
+    }
+    else
+    {
+        while (!ok && tries++ < MAX_TASKS)
+        {
+            task++;
+            if (task >= MAX_TASKS)
+                task = 0;
+            ok = (task != taskIdle && (tcb[task].state == STATE_READY || tcb[task].state == STATE_UNRUN));
+        }
+        return ok ? task : taskIdle;
+    }
+}
+
+// True if the scheduler could pick another task than the current one, a
+// ready task of lower priority only counts for the round-robin scheduler
+// and the idle task never counts
+bool otherTaskReady(void)
+{
+    uint8_t task;
+
+    for (task = 0; task < MAX_TASKS; task++)
+    {
+        if (task != taskCurrent && task != taskIdle && (tcb[task].state == STATE_READY || tcb[task].state == STATE_UNRUN)
+                && (!priorityScheduler || tcb[task].currentPriority <= tcb[taskCurrent].currentPriority))
+            return true;
+    }
+    return false;
+}
+
+// REQUIRED: modify this function to start the operating system
+// by calling scheduler, set srd bits, setting PSP, ASP bit, call fn with fn add in R0
+// fn set TMPL bit, and PC <= fn
+void startRtos(void)
+{
+    taskCurrent = rtosScheduler();
+    applySramSrdMasks(tcb[taskCurrent].srd);
+    setPsp((uint32_t)tcb[taskCurrent].sp); // sets psp to first tasks' sp
+    tcb[taskCurrent].state = STATE_READY;
+    tcb[taskCurrent].sliceLeft = quantum[tcb[taskCurrent].currentPriority];
+    tcb[taskCurrent].switches++;
+    idleStart = readCycleCounter();
+    usePsp();
+    setPcTmpl(tcb[taskCurrent].pid); // enables privileged mode
+}
+
+// REQUIRED:
+// add task if room in task list - done
+// store the thread name
+// allocate stack space and store top of stack in sp and spInit - done
+// set the srd bits based on the memory allocation - done
+// Returns the handle of the thread, NO_THREAD if it could not be added
+// Running tasks can create threads too, destroyThread gives the stack back
+_thread createThread(_fn fn, const char name[], uint8_t priority, uint32_t stackBytes)
+{
+    _thread thread = NO_THREAD;
+    uint8_t bucket;
+    uint8_t region;
+    uint8_t i = 0;
+    void *stack;
+
+    // a running task is unprivileged and has the kernel do it
+    if (!isPrivileged())
+        return spawnThread(fn, name, priority, stackBytes);
+
+    if (taskCount < MAX_TASKS)
+    {
+        // threads are told apart by handle, so several can run the same fn
+        stack = mallocFromHeap(stackBytes);
+        if (stack)
+        {
+            // find first available tcb record
+            while (tcb[i].state != STATE_INVALID) {i++;}
+
+            tcb[i].state = STATE_UNRUN;
+            tcb[i].generation = tcb[i].generation == 0xFF ? 1 : tcb[i].generation + 1;
+            tcb[i].pid = fn;
+            tcb[i].spInit = (void *) ((uint32_t)stack + (stackBytes - 1));
+            tcb[i].sp = tcb[i].spInit;
+            tcb[i].priority = priority;
+            tcb[i].currentPriority = priority;
+            tcb[i].ticks = 0;
+            tcb[i].waitResult = 0;
+            tcb[i].switches = 0;
+            tcb[i].sliceEnds = 0;
+            CopyStrings((char*)name, tcb[i].name);
+            traceName(i, tcb[i].name);
+            bucket = hashName(tcb[i].name);
+            tcb[i].nameNext = nameIndex[bucket];
+            nameIndex[bucket] = i;
+            // tcb[i].name[0] = i + 65;
+            //tcb[i].name[1] = 0;
+            // a reused record must not keep the srd bits of the last thread
+            for (region = 0; region < NUM_SRAM_REGIONS; region++)
+                tcb[i].srd[region] = 0;
+            generateSramSrdMasks(tcb[i].srd, tcb[i].spInit, stackBytes); //spinit - (stackBytes + 1)
+
+            // increment task count
+            taskCount++;
+            thread = getHandle(i);
+        }
+    }
+    return thread;
+}
+
+// Allocates a pool of worker threads that run the jobs of submitJob, named
+// PoolN-M (before startRtos, the idle semaphore comes from the pool like
+// createSemaphore)
+// Returns NO_OBJECT if the pools, worker deques or semaphores are used up,
+// or a worker cannot be created, which leaves nothing allocated
+uint8_t createPool(uint8_t workers, uint8_t priority, uint32_t stackBytes)
+{
+    char name[] = "Pool0-0";
+    jobDeque *deque;
+    _thread worker;
+    uint8_t p = 0;
+    uint8_t i;
+
+    while (p < MAX_POOLS && pools[p].inUse)
+        p++;
+
+    if (p == MAX_POOLS || !workers || workers > MAX_POOL_WORKERS - jobDequesUsed)
+        return NO_OBJECT;
+
+    pools[p].idle = createSemaphore(0);
+    if (pools[p].idle == NO_OBJECT)
+        return NO_OBJECT;
+
+    // the deques are only claimed once every worker exists
+    name[4] += p;
+    for (i = 0; i < workers; i++)
+    {
+        name[6] = '0' + i;
+        worker = createThread(poolWorker, name, priority, stackBytes);
+        if (worker == NO_THREAD)
+            break;
+
+        deque = &jobDeques[jobDequesUsed + i];
+        deque->worker = worker;
+        deque->pool = p;
+        deque->head = 0;
+        deque->count = 0;
+    }
+
+    if (i < workers)
+    {
+        while (i--)
+            removeThread(jobDeques[jobDequesUsed + i].worker & 0xFF);
+        semaphores[pools[p].idle].inUse = false;
+        return NO_OBJECT;
+    }
+
+    pools[p].first = jobDequesUsed;
+    pools[p].workers = workers;
+    pools[p].next = 0;
+    pools[p].inUse = true;
+    jobDequesUsed += workers;
+    return p;
+}
+
+// Runs the work queued by interrupt handlers and timers, in order, one item
+// at a time
+// The items run unprivileged with the MPU set up for this task, so they use
+// kernel calls (post, setFlags, sendMessage...) to reach other tasks
+void workTask(void)
+{
+    workItem item;
+
+    while (true)
+    {
+        getWork(&item);
+        item.fn(item.arg);
+    }
+}
+
+// Runs the jobs of its pool, its own first, then the ones it can steal
+// Like the work task it runs them unprivileged with its own MPU setup
+void poolWorker(void)
+{
+    workItem job;
+
+    while (true)
+        if (getJob(&job))
+            job.fn(job.arg);
+}
+
+// Runs when no other task is ready: calls the idle hook, sleeps until the
+// next interrupt and then lets whatever the interrupt made ready run
+// The kernel counts the time from each switch to this task to the next
+// switch away from it as idle time
+void idleTask(void)
+{
+    _fn hook = getIdleHook();
+
+    while (true)
+    {
+        if (hook)
+            hook();
+        waitForInterrupt();
+        yield();
+    }
+}
+
+// Takes the semaphore if the count allows it, without blocking
+bool tryWait(uint8_t semaphore)
+{
+    return waitTimeout(semaphore, 0);
+}
+
+// Locks the mutex if it is free, without blocking
+bool tryLock(uint8_t mutex)
+{
+    return lockTimeout(mutex, 0);
+}
+
+// Kernel calls for interrupt handlers at KERNEL_PRIORITY or lower
+// SVC and SysTick cannot be entered while they run, BASEPRI keeps the other
+// handlers that call the kernel out, and PendSV is only requested when a task
+// of higher priority than the interrupted one became ready and preemption is
+// on (like in systickIsr, a cooperative task keeps the cpu until it gives it
+// up, the idle task yields after every interrupt)
+
+// Ends a FromIsr call, switching tasks on exit if needed
+void leaveIsrCall(uint32_t basepri)
+{
+    if (preemption && higherReady)
+        NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+    higherReady = false;
+    setBasepri(basepri);
+}
+
+bool postFromIsr(uint8_t semaphore)
+{
+    uint32_t basepri;
+
+    if (!isSemaphore(semaphore))
+        return false;
+
+    basepri = setBasepri(KERNEL_PRIORITY);
+    postSemaphore(semaphore);
+    leaveIsrCall(basepri);
+    return true;
+}
+
+bool setFlagsFromIsr(uint8_t group, uint32_t flags)
+{
+    uint32_t basepri;
+
+    if (!isEventGroup(group))
+        return false;
+
+    basepri = setBasepri(KERNEL_PRIORITY);
+    raiseFlags(group, flags);
+    leaveIsrCall(basepri);
+    return true;
+}
+
+// Copies a message into a copy queue, never blocks
+// Returns false if the queue is full
+bool sendMessageFromIsr(uint8_t queue, const void *msg)
+{
+    uint32_t basepri;
+    bool ok;
+
+    if (!isQueue(queue) || queues[queue].blocks)
+        return false;
+
+    basepri = setBasepri(KERNEL_PRIORITY);
+    ok = (queues[queue].count < queues[queue].depth || queues[queue].receivers.head != NO_TASK);
+    if (ok)
+        putMessage(queue, msg, false);
+    leaveIsrCall(basepri);
+    return ok;
+}
+
+// Queues fn(arg) for the work task, so the handler returns at once and the
+// processing runs in thread context
+// Returns false if the queue is full (or initWorkQueue was not called)
+bool queueWorkFromIsr(_workFn fn, uint32_t arg)
+{
+    workItem item;
+
+    item.fn = fn;
+    item.arg = arg;
+    return sendMessageFromIsr(workQueue, &item);
+}
+
+// Queues fn(arg) for a worker of pool, like submitJob
+// Returns false if every deque of the pool is full
+bool submitJobFromIsr(uint8_t pool, _workFn fn, uint32_t arg)
+{
+    uint32_t basepri;
+    bool ok;
+
+    if (!isPool(pool))
+        return false;
+
+    basepri = setBasepri(KERNEL_PRIORITY);
+    ok = putJob(pool, fn, arg, NO_TASK);
+    leaveIsrCall(basepri);
+    return ok;
+}
+
+// Compare interrupt of the microsecond timer, at KERNEL_PRIORITY
+void microTimerIsr(void)
+{
+    uint32_t basepri;
+
+    basepri = setBasepri(KERNEL_PRIORITY);
+    traceEvent(TRACE_ISR_ENTER, INT_WTIMER0A);
+    wakeMicroSleepers();
+    traceEvent(TRACE_ISR_EXIT, INT_WTIMER0A);
+    leaveIsrCall(basepri);
+}
+
+// REQUIRED: modify this function to add support for the system timer
+// REQUIRED: in preemptive code, add code to request task switch
+void systickIsr(void)
+{
+    uint8_t task;
+    traceEvent(TRACE_ISR_ENTER, 15);
+    tickCount++;
+    if (timerHead != NO_OBJECT)
+        expireTimers();
+    // also covers boards without a compare interrupt, at 1 ms resolution
+    if (microAlarm && now_us() >= microAlarm)
+        wakeMicroSleepers();
+    for (task = 0; task < MAX_TASKS; task++)
+    {
+        if (tcb[task].state == STATE_DELAYED)
+        {
+            tcb[task].ticks--;
+
+            if (!tcb[task].ticks)
+                wakeWaiter(task, 0);
+        }
+        else if (tcb[task].state >= STATE_BLOCKED_MUTEX && tcb[task].ticks)
+        {
+            tcb[task].ticks--;
+
+            if (!tcb[task].ticks)
+                expireWaiter(task);
+        }
+    }
+
+    // the running task keeps the cpu until its quantum runs out (and another
+    // task can take over) or a task of higher priority got ready
+    if (preemption)
+    {
+        if (tcb[taskCurrent].sliceLeft)
+            tcb[taskCurrent].sliceLeft--;
+        if (!tcb[taskCurrent].sliceLeft && otherTaskReady())
+        {
+            tcb[taskCurrent].sliceEnds++;
+            NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+        }
+        else if (higherReady)
+            NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+        else if (!tcb[taskCurrent].sliceLeft)
+            tcb[taskCurrent].sliceLeft = quantum[tcb[taskCurrent].currentPriority];
+    }
+    // without preemption the tasks woken here wait for the next switch
+    higherReady = false;
+    traceEvent(TRACE_ISR_EXIT, 15);
+
+    // togglePinValue(PORTD,1);
+    // NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PENDSTCLR;
+}
+
+// REQUIRED: in coop and preemptive, modify this function to add support for task switching
+// REQUIRED: process UNRUN and READY tasks differently
+void pendSvIsr(void)
+{
+    uint32_t basepri;
+    uint8_t task;
+
+    strRegs();
+
+    // interrupts that call the kernel may preempt PendSV, not the scheduler
+    basepri = setBasepri(KERNEL_PRIORITY);
+    // a task that restarted itself starts over at spInit
+    if (tcb[taskCurrent].state != STATE_UNRUN)
+        tcb[taskCurrent].sp = (void *)getPsp();
+    if (taskCurrent == taskIdle)
+        idleCycles += readCycleCounter() - idleStart;
+    task = rtosScheduler();
+    if (task != taskCurrent)
+        tcb[task].switches++;
+    taskCurrent = task;
+    tcb[taskCurrent].sliceLeft = quantum[tcb[taskCurrent].currentPriority];
+    if (taskCurrent == taskIdle)
+        idleStart = readCycleCounter();
+    higherReady = false;
+    traceEvent(TRACE_SWITCH, taskCurrent);
+    setBasepri(basepri);
+    setPsp((uint32_t)tcb[taskCurrent].sp);
+    applySramSrdMasks(tcb[taskCurrent].srd);
+
+    if (tcb[taskCurrent].state == STATE_READY)
+        ldrRegs();
+    else
+    {
+        tcb[taskCurrent].state = STATE_READY;
+        runProgram(tcb[taskCurrent].pid);
+    }
+
+}
+
+// SVC handlers, one per line of syscalls.h
+// args is the exception frame of the caller, args[0-3] hold R0-R3 already
+// checked by svCallIsr, and what a handler returns ends up in R0
+// A handler that blocks returns the result of a timeout and points
+// waitResult at args[0] for the wake-up to overwrite
+
+uint32_t yieldSvc(uint32_t args[])
+{
+    // the scheduler would pick the caller again, skip the switch
+    if (otherTaskReady())
+        NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+    return 0;
+}
+
+uint32_t sleepSvc(uint32_t args[])
+{
+    tcb[taskCurrent].state = STATE_DELAYED;
+    tcb[taskCurrent].ticks = args[0];
+    NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+    return 0;
+}
+
+uint32_t lockSvc(uint32_t args[])
+{
+    uint8_t mutex = args[0];
+
+    // if mutex free
+    if (mutexes[mutex].lock == false)
+    {
+        // lock it man
+        mutexes[mutex].lock = true;
+        // specify who locked it
+        mutexes[mutex].lockedBy = taskCurrent;
+        traceEvent(TRACE_MTX_LOCK, mutex);
+    }
+    else
+    {
+        // join the mutex wait list and switch task
+        blockOnMutex(mutex, 0);
+    }
+    return 0;
+}
+
+uint32_t unlockSvc(uint32_t args[])
+{
+    uint8_t mutex = args[0];
+
+    // if you locked it, unlock it and hand it to the next waiter
+    if (mutexes[mutex].lock && mutexes[mutex].lockedBy == taskCurrent)
+        releaseMutex(mutex);
+    return 0;
+}
+
+uint32_t waitSvc(uint32_t args[])
+{
+    uint8_t semaphore = args[0];
+
+    // decrement count number if there is a count
+    if (semaphores[semaphore].count > 0)
+    {
+        semaphores[semaphore].count--;
+        traceEvent(TRACE_SEM_WAIT, semaphore);
+    }
+    else
+    {
+        // join the semaphore wait list and switch task
+        blockOnSemaphore(semaphore, 0);
+    }
+    return 0;
+}
+
+uint32_t postSvc(uint32_t args[])
+{
+    // if someone is waiting, the count goes straight to them
+    postSemaphore(args[0]);
+    return 0;
+}
+
+uint32_t getPidSvc(uint32_t args[])
+{
+    const char *name = (const char *)args[0];
+    uint8_t task = nameIndex[hashName(name)];
+
+    while (task != NO_TASK && !stringsEqual(tcb[task].name, name))
+        task = tcb[task].nameNext;
+
+    return task == NO_TASK ? NO_THREAD : getHandle(task);
+}
+
+// thread handles are checked by svCallIsr, the low byte is the tcb record
+uint32_t restartThreadSvc(uint32_t args[])
+{
+    uint8_t task = args[0] & 0xFF;
+
+    // nothing on the old stack survives, so neither do the locks and blocks
+    // it held
+    releaseThread(task);
+    releaseBlocks(task);
+    tcb[task].currentPriority = tcb[task].priority;
+
+    // UNRUN makes pendSvIsr build a fresh frame at the top of the stack
+    tcb[task].sp = tcb[task].spInit;
+    tcb[task].state = STATE_UNRUN;
+    if (task == taskCurrent)
+        NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+    return 0;
+}
+
+uint32_t preemptSvc(uint32_t args[])
+{
+    preemption = args[0];
+    return 0;
+}
+
+uint32_t stopThreadSvc(uint32_t args[])
+{
+    uint8_t task = args[0] & 0xFF;
+
+    // the scheduler needs the idle task
+    if (task == taskIdle)
+        return 0;
+
+    releaseThread(task);
+    tcb[task].state = STATE_STOPPED;
+    return 0;
+}
+
+uint32_t rebootSvc(uint32_t args[])
+{
+    NVIC_APINT_R = NVIC_APINT_VECTKEY | NVIC_APINT_SYSRESETREQ;
+    return 0;
+}
+
+uint32_t setThreadPrioritySvc(uint32_t args[])
+{
+    uint8_t task = args[0] & 0xFF;
+
+    tcb[task].priority = args[1];
+
+    // a waiter on a priority-ordered object moves to its new place
+    if (tcb[task].state == STATE_BLOCKED_MUTEX && mutexes[tcb[task].mutex].priorityOrder)
+    {
+        removeWaiter(&mutexes[tcb[task].mutex].waiters, task);
+        addWaiter(&mutexes[tcb[task].mutex].waiters, task, tcb[task].priority);
+    }
+    if (tcb[task].state == STATE_BLOCKED_SEMAPHORE && semaphores[tcb[task].semaphore].priorityOrder)
+    {
+        removeWaiter(&semaphores[tcb[task].semaphore].waiters, task);
+        addWaiter(&semaphores[tcb[task].semaphore].waiters, task, tcb[task].priority);
+    }
+
+    // what it inherits, and what it passes on to the holder it waits for
+    updatePriority(task);
+    return 0;
+}
+
+uint32_t getMutexInfoSvc(uint32_t args[])
+{
+    IPCS_MUT_DATA *mut_data = (IPCS_MUT_DATA*)args[0];
+    uint8_t mutex = args[1];
+    uint8_t task;
+    uint8_t i;
+
+    mut_data->lock = mutexes[mutex].lock;
+    mut_data->queueSize = mutexes[mutex].queueSize;
+    mut_data->lockedByName[0] = '\0';
+    if (mutexes[mutex].lock)
+        CopyStrings(tcb[mutexes[mutex].lockedBy].name, mut_data->lockedByName);
+
+    // first waiters in wake order
+    task = mutexes[mutex].waiters.head;
+    for (i = 0; i < 2; i++)
+    {
+        mut_data->queueNames[i][0] = '\0';
+        if (task != NO_TASK)
+        {
+            CopyStrings(tcb[task].name, mut_data->queueNames[i]);
+            task = tcb[task].next;
+        }
+    }
+    return 0;
+}
+
+uint32_t getSemaphoreInfoSvc(uint32_t args[])
+{
+    IPCS_SEM_DATA *sem_data = (IPCS_SEM_DATA*)args[0];
+    uint8_t semaphore = args[1];
+    uint8_t task;
+    uint8_t i;
+
+    sem_data->count = semaphores[semaphore].count;
+    sem_data->queueSize = semaphores[semaphore].queueSize;
+
+    // first waiters in wake order
+    task = semaphores[semaphore].waiters.head;
+    for (i = 0; i < 2; i++)
+    {
+        sem_data->queueNames[i][0] = '\0';
+        if (task != NO_TASK)
+        {
+            CopyStrings(tcb[task].name, sem_data->queueNames[i]);
+            task = tcb[task].next;
+        }
+    }
+    return 0;
+}
+
+uint32_t schedSvc(uint32_t args[])
+{
+    priorityScheduler = args[0];
+    return 0;
+}
+
+uint32_t getTcbSvc(uint32_t args[])
+{
+    uint8_t task = 0;
+    PS_DATA *ps_data = (PS_DATA*)args[0];
+
+    while(task < MAX_TASKS)
+    {
+        if (tcb[task].state != STATE_INVALID)
+        {
+            CopyStrings(tcb[task].name, (ps_data->name[task]));
+            ps_data->pid[task] = getHandle(task);
+            ps_data->switches[task] = tcb[task].switches;
+            ps_data->sliceEnds[task] = tcb[task].sliceEnds;
+            ps_data->quantum[task] = quantum[tcb[task].currentPriority];
+        }
+        else
+        {
+            ps_data->name[task][0] = '\0';
+            ps_data->pid[task] = 0;
+        }
+        task++;
+    }
+    ps_data->upTime = now_us() / 1000;
+    ps_data->idleTime = idleCycles / (BOARD_CLOCK_HZ / 1000);
+    return 0;
+}
+
+uint32_t copyTraceSvc(uint32_t args[])
+{
+    traceCopy((TRACE_DATA *)args[0]);
+    return 0;
+}
+
+uint32_t waitTimeoutSvc(uint32_t args[])
+{
+    uint8_t semaphore = args[0];
+    uint32_t ticks = args[1];
+
+    if (semaphores[semaphore].count > 0)
+    {
+        semaphores[semaphore].count--;
+        traceEvent(TRACE_SEM_WAIT, semaphore);
+        return true;
+    }
+
+    // returns false unless a post wakes it before the ticks run out
+    if (ticks)
+    {
+        tcb[taskCurrent].waitResult = args;
+        blockOnSemaphore(semaphore, ticks == WAIT_FOREVER ? 0 : ticks);
+    }
+    return false;
+}
+
+uint32_t lockTimeoutSvc(uint32_t args[])
+{
+    uint8_t mutex = args[0];
+    uint32_t ticks = args[1];
+
+    if (mutexes[mutex].lock == false)
+    {
+        mutexes[mutex].lock = true;
+        mutexes[mutex].lockedBy = taskCurrent;
+        traceEvent(TRACE_MTX_LOCK, mutex);
+        return true;
+    }
+
+    // returns false unless an unlock hands it over in time
+    if (ticks)
+    {
+        tcb[taskCurrent].waitResult = args;
+        blockOnMutex(mutex, ticks == WAIT_FOREVER ? 0 : ticks);
+    }
+    return false;
+}
+
+uint32_t setFlagsSvc(uint32_t args[])
+{
+    raiseFlags(args[0], args[1]);
+    return 0;
+}
+
+uint32_t clearFlagsSvc(uint32_t args[])
+{
+    uint8_t group = args[0];
+    uint32_t flags = eventGroups[group].flags;
+
+    eventGroups[group].flags &= ~args[1];
+    return flags;
+}
+
+uint32_t waitFlagsSvc(uint32_t args[])
+{
+    uint8_t group = args[0];
+    uint32_t mask = args[1];
+    uint8_t mode = args[2];
+    uint32_t ticks = args[3];
+    uint32_t match;
+
+    if (!mask)
+        return 0;
+
+    match = matchFlags(eventGroups[group].flags, mask, mode);
+    if (match)
+    {
+        if (mode & FLAGS_CLEAR)
+            eventGroups[group].flags &= ~mask;
+    }
+    else if (ticks)
+    {
+        // returns 0 unless a set satisfies it in time
+        tcb[taskCurrent].waitResult = args;
+        blockOnFlags(group, mask, mode, ticks == WAIT_FOREVER ? 0 : ticks);
+    }
+    return match;
+}
+
+// sendMessage and sendUrgentMessage
+bool sendOrBlock(uint32_t args[], bool urgent)
+{
+    uint8_t q = args[0];
+    uint8_t *msg = (uint8_t *)args[1];
+    uint32_t ticks = args[2];
+
+    // a block can only be sent by its owner, and not while shared
+    if (queues[q].blocks && (getMessageBlock(msg) == NO_OBJECT
+            || blockOwner[getMessageBlock(msg)] != taskCurrent
+            || blockSharer[getMessageBlock(msg)] != NO_TASK))
+        return false;
+
+    if (queues[q].count < queues[q].depth || queues[q].receivers.head != NO_TASK)
+    {
+        putMessage(q, msg, urgent);
+        return true;
+    }
+
+    // returns false unless a receiver makes room in time
+    if (ticks)
+    {
+        tcb[taskCurrent].waitResult = args;
+        blockOnQueue(q, STATE_BLOCKED_SEND, msg, urgent, ticks == WAIT_FOREVER ? 0 : ticks);
+    }
+    return false;
+}
+
+uint32_t sendMessageSvc(uint32_t args[])
+{
+    return sendOrBlock(args, false);
+}
+
+uint32_t sendUrgentMessageSvc(uint32_t args[])
+{
+    return sendOrBlock(args, true);
+}
+
+uint32_t receiveMessageSvc(uint32_t args[])
+{
+    uint8_t q = args[0];
+    uint8_t *msg = (uint8_t *)args[1];
+    uint32_t ticks = args[2];
+
+    if (queues[q].count)
+    {
+        getMessage(q, msg, taskCurrent);
+        return true;
+    }
+
+    // returns false unless a sender fills msg in time
+    if (ticks)
+    {
+        tcb[taskCurrent].waitResult = args;
+        blockOnQueue(q, STATE_BLOCKED_RECEIVE, msg, false, ticks == WAIT_FOREVER ? 0 : ticks);
+    }
+    return false;
+}
+
+uint32_t allocBlockSvc(uint32_t args[])
+{
+    uint8_t block = 0;
+
+    while (block < blockCount && blockOwner[block] != BLOCK_FREE)
+        block++;
+
+    if (block == blockCount)
+        return 0;
+
+    setBlockOwner(block, taskCurrent);
+    return (uint32_t)(blockBase + block * BLOCK_SIZE);
+}
+
+uint32_t freeBlockSvc(uint32_t args[])
+{
+    uint8_t block = getBlock((uint8_t *)args[0]);
+    bool ok = (block != NO_OBJECT && blockOwner[block] == taskCurrent);
+
+    if (ok)
+        returnBlock(block);
+    return ok;
+}
+
+uint32_t shareBlockSvc(uint32_t args[])
+{
+    uint8_t block = getBlock((uint8_t *)args[0]);
+    uint8_t task = args[1] & 0xFF;
+    bool ok;
+
+    ok = block != NO_OBJECT && blockOwner[block] == taskCurrent
+            && blockSharer[block] == NO_TASK && task != taskCurrent;
+    if (ok)
+    {
+        blockSharer[block] = task;
+        grantBlock(block, task, true);
+    }
+    return ok;
+}
+
+uint32_t condWaitSvc(uint32_t args[])
+{
+    uint8_t cv = args[0];
+    uint8_t mutex = args[1];
+
+    // only the holder of the mutex can wait
+    if (!mutexes[mutex].lock || mutexes[mutex].lockedBy != taskCurrent)
+        return false;
+
+    releaseMutex(mutex);
+    blockOnCondVar(cv, mutex);
+    return true;
+}
+
+uint32_t condSignalSvc(uint32_t args[])
+{
+    signalCondVar(args[0]);
+    return 0;
+}
+
+uint32_t condBroadcastSvc(uint32_t args[])
+{
+    while (signalCondVar(args[0]));
+    return 0;
+}
+
+uint32_t readLockSvc(uint32_t args[])
+{
+    uint8_t rw = args[0];
+
+    if (holdsRwLock(rw, taskCurrent))
+        return 0;
+
+    // a waiting writer goes first
+    if (!rwLocks[rw].writer && !rwLocks[rw].writeQueueSize)
+    {
+        rwLocks[rw].readers++;
+        rwLocks[rw].readerMask |= 1 << taskCurrent;
+    }
+    else
+        blockOnRwLock(rw, STATE_BLOCKED_READ);
+    return 0;
+}
+
+uint32_t readUnlockSvc(uint32_t args[])
+{
+    uint8_t rw = args[0];
+
+    if (rwLocks[rw].readerMask & (1 << taskCurrent))
+        releaseRwLock(rw, taskCurrent);
+    return 0;
+}
+
+uint32_t writeLockSvc(uint32_t args[])
+{
+    uint8_t rw = args[0];
+
+    if (holdsRwLock(rw, taskCurrent))
+        return 0;
+
+    if (!rwLocks[rw].writer && !rwLocks[rw].readers)
+    {
+        rwLocks[rw].writer = true;
+        rwLocks[rw].writerTask = taskCurrent;
+    }
+    else
+        blockOnRwLock(rw, STATE_BLOCKED_WRITE);
+    return 0;
+}
+
+uint32_t writeUnlockSvc(uint32_t args[])
+{
+    uint8_t rw = args[0];
+
+    if (rwLocks[rw].writer && rwLocks[rw].writerTask == taskCurrent)
+        releaseRwLock(rw, taskCurrent);
+    return 0;
+}
+
+uint32_t getRwLockInfoSvc(uint32_t args[])
+{
+    IPCS_RW_DATA *rw_data = (IPCS_RW_DATA*)args[0];
+    uint8_t rw = args[1];
+
+    rw_data->readers = rwLocks[rw].readers;
+    rw_data->writer = rwLocks[rw].writer;
+    rw_data->readQueueSize = rwLocks[rw].readQueueSize;
+    rw_data->writeQueueSize = rwLocks[rw].writeQueueSize;
+    rw_data->readContended = rwLocks[rw].readContended;
+    rw_data->writeContended = rwLocks[rw].writeContended;
+    rw_data->writerName[0] = '\0';
+    if (rwLocks[rw].writer)
+        CopyStrings(tcb[rwLocks[rw].writerTask].name, rw_data->writerName);
+    return true;
+}
+
+uint32_t piSvc(uint32_t args[])
+{
+    uint8_t task;
+
+    priorityInheritance = args[0];
+    for (task = 0; task < MAX_TASKS; task++)
+        if (tcb[task].state != STATE_INVALID)
+            updatePriority(task);
+    return 0;
+}
+
+uint32_t getWorkSvc(uint32_t args[])
+{
+    uint8_t *item = (uint8_t *)args[0];
+
+    if (!isQueue(workQueue))
+        return 0;
+
+    // like receiveMessage on the work queue, waiting forever
+    if (queues[workQueue].count)
+        getMessage(workQueue, item, taskCurrent);
+    else
+        blockOnQueue(workQueue, STATE_BLOCKED_RECEIVE, item, false, 0);
+    return 0;
+}
+
+uint32_t getJobSvc(uint32_t args[])
+{
+    uint8_t own = getJobDeque(taskCurrent);
+
+    if (own == NO_OBJECT)
+        return false;
+
+    if (takeJob(own, (workItem *)args[0]))
+        return true;
+
+    // woken by the next putJob, the worker then asks again
+    blockOnSemaphore(pools[jobDeques[own].pool].idle, 0);
+    return false;
+}
+
+uint32_t submitJobSvc(uint32_t args[])
+{
+    return putJob(args[0], (_workFn)args[1], args[2], taskCurrent);
+}
+
+uint32_t startTimerSvc(uint32_t args[])
+{
+    uint8_t timer = args[0];
+    uint32_t ticks = args[1];
+
+    if (!ticks || !isQueue(workQueue))
+        return false;
+
+    if (timers[timer].running)
+        removeTimer(timer);
+    timers[timer].period = ticks;
+    timers[timer].autoReload = args[2];
+    timers[timer].expiry = tickCount + ticks;
+    addTimer(timer);
+    return true;
+}
+
+uint32_t stopTimerSvc(uint32_t args[])
+{
+    uint8_t timer = args[0];
+
+    if (!timers[timer].running)
+        return false;
+
+    removeTimer(timer);
+    return true;
+}
+
+uint32_t usleepSvc(uint32_t args[])
+{
+    uint32_t us = args[0];
+
+    if (us > INT32_MAX)
+        us = INT32_MAX;
+    tcb[taskCurrent].state = STATE_DELAYED_US;
+    tcb[taskCurrent].ticks = (uint32_t)now_us() + us;
+    wakeMicroSleepers();
+    NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+    return 0;
+}
+
+uint32_t getIdleHookSvc(uint32_t args[])
+{
+    return (uint32_t)idleHook;
+}
+
+uint32_t spawnThreadSvc(uint32_t args[])
+{
+    _thread thread = createThread((_fn)args[0], (const char *)args[1], args[2], args[3]);
+
+    // like a wake-up, a new thread above the caller makes the scheduler look
+    if (thread != NO_THREAD && args[2] < tcb[taskCurrent].currentPriority)
+        higherReady = true;
+    return thread;
+}
+
+uint32_t destroyThreadSvc(uint32_t args[])
+{
+    uint8_t task = args[0] & 0xFF;
+
+    // the scheduler needs the idle task
+    if (task == taskIdle)
+        return false;
+
+    removeThread(task);
+    if (task == taskCurrent)
+        NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+    return true;
+}
+
+// the table svCallIsr dispatches through, indexed by SVC number
+#define ARG(kind, size, param) { ARG_##kind, size }
+#define NO_ARG { ARG_NONE, 0 }
+#define SYSCALL(n, type, name, params, a0, a1, a2, a3) [n] = { name##Svc, { a0, a1, a2, a3 } },
+#define SYSCALL_VOID(n, name, params, a0, a1, a2, a3) [n] = { name##Svc, { a0, a1, a2, a3 } },
+const svcCall svcTable[] =
+{
+#include "syscalls.h"
+};
+#undef SYSCALL_VOID
+#undef SYSCALL
+#undef NO_ARG
+#undef ARG
+
+#define SVC_COUNT (sizeof(svcTable) / sizeof(svcTable[0]))
+
+// Checks that the calling task can read (or write) size bytes at p
+// Flash is readable by every task, SRAM only where its SRD mask opens it
+bool isUserPointer(uint32_t p, uint32_t size, bool write)
+{
+    if (!write && p < FLASH_SIZE && size <= FLASH_SIZE - p)
+        return true;
+    return isSramAccessible(tcb[taskCurrent].srd, (void *)p, size);
+}
+
+// Checks that the string at p ends within size bytes the calling task can read
+bool isUserString(uint32_t p, uint32_t size)
+{
+    uint32_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        // access changes at most once per 512 byte subregion
+        if ((i == 0 || ((p + i) & 511) == 0) && !isUserPointer(p + i, 1, false))
+            return false;
+        if (((const char *)p)[i] == '\0')
+            return true;
+    }
+    return false;
+}
+
+// Checks argument i of an SVC against its kind in the table
+bool isSvcArg(const svcArg *arg, uint32_t args[], uint8_t i)
+{
+    uint32_t value = args[i];
+
+    // object indices come in a uint8_t
+    if (arg->kind >= ARG_MUTEX && arg->kind <= ARG_POOL && value > 0xFF)
+        return false;
+
+    switch (arg->kind)
+    {
+        case ARG_BOOL:      return value <= 1;
+        case ARG_MUTEX:     return isMutex(value);
+        case ARG_SEMAPHORE: return isSemaphore(value);
+        case ARG_GROUP:     return isEventGroup(value);
+        case ARG_QUEUE:     return isQueue(value);
+        case ARG_COND:      return isCondVar(value);
+        case ARG_RW:        return isRwLock(value);
+        case ARG_TIMER:     return isTimer(value);
+        case ARG_POOL:      return isPool(value);
+        case ARG_PRIORITY:  return value < NUM_PRIORITIES;
+        case ARG_THREAD:    return isThread(value);
+        case ARG_STRING:    return isUserString(value, arg->size);
+        case ARG_IN:        return isUserPointer(value, arg->size, false);
+        case ARG_OUT:       return isUserPointer(value, arg->size, true);
+        case ARG_MSG_IN:    return isUserPointer(value, queues[args[0]].msgSize, false);
+        case ARG_MSG_OUT:   return isUserPointer(value, queues[args[0]].msgSize, true);
+        default:            return true;
+    }
+}
+
+// Decodes the SVC number from the instruction before the stacked PC, checks
+// the arguments and runs the handler, whose result goes to the stacked R0
+// An unknown call or a bad argument returns 0 without reaching the handler
+void svCallIsr(void)
+{
+    uint32_t *frame = getPsp();
+    uint8_t svc_num = *(uint8_t *)(frame[6] - 2);
+    const svcCall *call;
+    uint8_t i;
+
+    traceEvent(TRACE_SVC, svc_num);
+
+    if (svc_num >= SVC_COUNT || !svcTable[svc_num].handler)
+    {
+        frame[0] = 0;
+        return;
+    }
+
+    call = &svcTable[svc_num];
+
+    for (i = 0; i < 4; i++)
+    {
+        if (!isSvcArg(&call->arg[i], frame, i))
+        {
+            frame[0] = 0;
+            return;
+        }
+    }
+
+    frame[0] = call->handler(frame);
 }
 
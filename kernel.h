@@ -16,6 +16,7 @@
 //-----------------------------------------------------------------------------
 
 #include <stdint.h>
+#include "trace.h"
 #include "shell.h"
 
 //-----------------------------------------------------------------------------
@@ -25,47 +26,197 @@
 // function pointer
 typedef void (*_fn)();
 
+// thread handle from createThread or getPid: the tcb record in the low byte
+// and the generation of that record above it, so the handle of a thread that
+// is gone never reaches the thread that reuses its record
+typedef uint16_t _thread;
+#define NO_THREAD 0 // never a valid handle
+
+// deferred work function, runs in the work task with the argument it was queued with
+typedef void (*_workFn)(uint32_t arg);
+
+// ipc object pools (kernel RAM: 15 bytes per mutex, 14 per semaphore, 20 per
+// event group, 28 per queue, 12 per condition variable, 32 per rw lock),
+// waiters are only limited by MAX_TASKS
+// the whole image has 4 KiB of SRAM: with the sizes below kernel.c takes about
+// 2870 bytes, the trace ring 592, mm 72 and the MSP stack 512, which leaves
+// under 50 bytes, so shrink one pool before growing another (kernel.c does
+// not build when the pools, timers, blocks and queue buffer outgrow POOL_RAM)
+#define POOL_RAM 1720
+#ifndef MAX_MUTEXES
+#define MAX_MUTEXES 16
+#endif
+#ifndef MAX_SEMAPHORES
+#define MAX_SEMAPHORES 16
+#endif
+#ifndef MAX_EVENT_GROUPS
+#define MAX_EVENT_GROUPS 8
+#endif
+#ifndef MAX_QUEUES
+#define MAX_QUEUES 8
+#endif
+#ifndef MAX_COND_VARS
+#define MAX_COND_VARS 8
+#endif
+#ifndef MAX_RW_LOCKS
+#define MAX_RW_LOCKS 4
+#endif
+
+// software timers, 20 bytes of kernel RAM each
+#ifndef MAX_TIMERS
+#define MAX_TIMERS 8
+#endif
+
+// kernel RAM shared by the messages of every copy queue
+#ifndef QUEUE_BUFFER_SIZE
+#define QUEUE_BUFFER_SIZE 256
+#endif
+
+// message blocks for zero-copy queues, one 1 KiB MPU subregion each
+#ifndef MAX_BLOCKS
+#define MAX_BLOCKS 8
+#endif
+#define BLOCK_SIZE 1024
+#define NO_OBJECT 0xFF // returned by the create functions when the pool is full
+
+// timed waits: 0 never blocks, WAIT_FOREVER never times out
+#define WAIT_FOREVER 0xFFFFFFFF
+
+// waitFlags mode, FLAGS_ANY or FLAGS_ALL, optionally | FLAGS_CLEAR
+#define FLAGS_ANY   0
+#define FLAGS_ALL   1
+#define FLAGS_CLEAR 2
+
 // mutex
-#define MAX_MUTEXES 1
-#define MAX_MUTEX_QUEUE_SIZE 2
 #define resource 0
 
 // semaphore
-#define MAX_SEMAPHORES 3
-#define MAX_SEMAPHORE_QUEUE_SIZE 2
 #define keyPressed 0
 #define keyReleased 1
 #define flashReq 2
 
+// event group
+#define keyEvents 0
+
+// a block queue carries pointers to message blocks
+#define BLOCK_MESSAGE 0
+
+// work items interrupt handlers can have waiting for the work task
+#ifndef WORK_QUEUE_DEPTH
+#define WORK_QUEUE_DEPTH 8
+#endif
+
+// worker pools, the workers of every pool together and the jobs each one
+// can have queued (40 bytes of kernel RAM per worker)
+#ifndef MAX_POOLS
+#define MAX_POOLS 2
+#endif
+#ifndef MAX_POOL_WORKERS
+#define MAX_POOL_WORKERS 4
+#endif
+#ifndef POOL_DEQUE_DEPTH
+#define POOL_DEQUE_DEPTH 4
+#endif
+
 // tasks
 #define MAX_TASKS 12
 
+// stack of the idle task initRtos creates
+#ifndef IDLE_STACK_SIZE
+#define IDLE_STACK_SIZE 512
+#endif
+
+// interrupt priorities (the 3 implemented bits, 0x00 is the highest)
+// SVC and SysTick run at KERNEL_PRIORITY and PendSV below everything else
+// interrupts that call the FromIsr functions must run at KERNEL_PRIORITY or
+// lower, the kernel never masks the ones above it but they cannot call it
+#define KERNEL_PRIORITY 0x40
+#define PENDSV_PRIORITY 0xE0
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
 
 bool initMutex(uint8_t mutex);
 bool initSemaphore(uint8_t semaphore, uint8_t count);
+uint8_t createMutex(void);
+uint8_t createSemaphore(uint8_t count);
+bool initEventGroup(uint8_t group);
+uint8_t createEventGroup(void);
+uint8_t createQueue(uint8_t msgSize, uint8_t depth);
+bool initCondVar(uint8_t cv);
+uint8_t createCondVar(void);
+bool initRwLock(uint8_t rw);
+uint8_t createRwLock(void);
+bool initBlockPool(uint8_t count);
+bool initWorkQueue(uint8_t priority, uint32_t stackBytes);
+uint8_t createPool(uint8_t workers, uint8_t priority, uint32_t stackBytes);
+void setIdleHook(_fn hook);
+bool setQuantum(uint8_t priority, uint8_t ticks);
+uint8_t createTimer(_workFn fn, uint32_t arg);
+bool setMutexPriorityOrder(uint8_t mutex, bool on);
+bool setSemaphorePriorityOrder(uint8_t semaphore, bool on);
 
 void initRtos(void);
 void startRtos(void);
 
-bool createThread(_fn fn, const char name[], uint8_t priority, uint32_t stackBytes);
-void restartThread(_fn fn);
-void stopThread(_fn fn);
-void setThreadPriority(_fn fn, uint8_t priority);
+_thread createThread(_fn fn, const char name[], uint8_t priority, uint32_t stackBytes);
+void restartThread(_thread thread);
+void stopThread(_thread thread);
+void setThreadPriority(_thread thread, uint8_t priority);
+_thread spawnThread(_fn fn, const char name[], uint8_t priority, uint32_t stackBytes);
+bool destroyThread(_thread thread);
 
-uint32_t getPid(const char name[]);
+_thread getPid(const char name[]);
 void getMutexInfo(IPCS_MUT_DATA *mutex_data, uint8_t mutex);
 void getSemaphoreInfo(IPCS_SEM_DATA *sem_data, uint8_t semaphore);
+bool getRwLockInfo(IPCS_RW_DATA *rw_data, uint8_t rw);
 void getTcb(PS_DATA *ps_data);
+void copyTrace(TRACE_DATA *trace);
 void yield(void);
 void sleep(uint32_t tick);
-void lock(int8_t mutex);
-void unlock(int8_t mutex);
-void wait(int8_t semaphore);
-void post(int8_t semaphore);
-
+void usleep(uint32_t us);
+void lock(uint8_t mutex);
+void unlock(uint8_t mutex);
+void wait(uint8_t semaphore);
+void post(uint8_t semaphore);
+bool waitTimeout(uint8_t semaphore, uint32_t ticks);
+bool lockTimeout(uint8_t mutex, uint32_t ticks);
+bool tryWait(uint8_t semaphore);
+bool tryLock(uint8_t mutex);
+void setFlags(uint8_t group, uint32_t flags);
+uint32_t clearFlags(uint8_t group, uint32_t flags);
+uint32_t waitFlags(uint8_t group, uint32_t mask, uint8_t mode, uint32_t ticks);
+bool sendMessage(uint8_t queue, const void *msg, uint32_t ticks);
+bool sendUrgentMessage(uint8_t queue, const void *msg, uint32_t ticks);
+bool receiveMessage(uint8_t queue, void *msg, uint32_t ticks);
+void *allocBlock(void);
+bool freeBlock(void *block);
+bool shareBlock(void *block, _thread thread);
+bool condWait(uint8_t cv, uint8_t mutex);
+void condSignal(uint8_t cv);
+void condBroadcast(uint8_t cv);
+void readLock(uint8_t rw);
+void readUnlock(uint8_t rw);
+void writeLock(uint8_t rw);
+void writeUnlock(uint8_t rw);
+
+bool postFromIsr(uint8_t semaphore);
+bool setFlagsFromIsr(uint8_t group, uint32_t flags);
+bool sendMessageFromIsr(uint8_t queue, const void *msg);
+bool queueWorkFromIsr(_workFn fn, uint32_t arg);
+bool submitJob(uint8_t pool, _workFn fn, uint32_t arg);
+bool submitJobFromIsr(uint8_t pool, _workFn fn, uint32_t arg);
+bool startTimer(uint8_t timer, uint32_t ticks, bool autoReload);
+bool stopTimer(uint8_t timer);
+void getWork(void *item);
+void workTask(void);
+bool getJob(void *job);
+void poolWorker(void);
+_fn getIdleHook(void);
+void idleTask(void);
+
+void microTimerIsr(void);
 void systickIsr(void);
 void pendSvIsr(void);
 void svCallIsr(void);
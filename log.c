@@ -0,0 +1,154 @@
+// Tokenized logging functions
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Frame format (decoded by tools/logtok.py):
+//   0x00, length, varint token, varint arg0, ... varint argN
+// length counts the bytes after itself, varints are LEB128 (7 bits per byte,
+// MSB set on every byte except the last)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include "uart0.h"
+#include "log.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Encodes value as a LEB128 varint into buf, returns the number of bytes used
+uint8_t putVarint(uint8_t buf[], uint32_t value)
+{
+    uint8_t len = 0;
+
+    while (value >= 0x80)
+    {
+        buf[len++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    buf[len++] = value;
+
+    return len;
+}
+
+// Sends one binary log frame, arguments are promoted to 32 bits
+void logTokenized(uint32_t token, uint8_t argc, ...)
+{
+    // start + length + (token + args) * 5 bytes worst case
+    uint8_t frame[2 + (LOG_MAX_ARGS + 1) * 5];
+    uint8_t len = 2;
+    uint8_t i;
+    va_list args;
+
+    len += putVarint(&frame[len], token);
+
+    va_start(args, argc);
+    for (i = 0; i < argc && i < LOG_MAX_ARGS; i++)
+        len += putVarint(&frame[len], va_arg(args, uint32_t));
+    va_end(args);
+
+    frame[0] = LOG_FRAME_START;
+    frame[1] = len - 2;
+
+    for (i = 0; i < len; i++)
+        putcUart0(frame[i]);
+}
+
+// Writes num in the given base, padded to width with pad characters
+static void logNumber(uint32_t num, uint8_t base, bool upper, uint8_t width, char pad)
+{
+    char digits[11];
+    uint8_t len = 0;
+    uint8_t digit;
+
+    do
+    {
+        digit = num % base;
+        digits[len++] = digit < 10 ? '0' + digit : (upper ? 'A' : 'a') + digit - 10;
+        num /= base;
+    }
+    while (num);
+
+    while (width > len)
+    {
+        putcUart0(pad);
+        width--;
+    }
+    while (len)
+        putcUart0(digits[--len]);
+}
+
+// Formats the same strings as LOG() on target, used when LOG_TOKENIZED is 0
+void logText(const char fmt[], uint8_t argc, ...)
+{
+    uint8_t i = 0;
+    uint8_t width;
+    char pad;
+    int32_t value;
+    va_list args;
+
+    va_start(args, argc);
+    while (fmt[i] != '\0')
+    {
+        if (fmt[i] != '%')
+        {
+            putcUart0(fmt[i++]);
+            continue;
+        }
+        i++;
+
+        pad = ' ';
+        if (fmt[i] == '0')
+        {
+            pad = '0';
+            i++;
+        }
+        width = 0;
+        while (fmt[i] >= '0' && fmt[i] <= '9')
+            width = width * 10 + (fmt[i++] - '0');
+
+        switch (fmt[i])
+        {
+            case 'u':
+                logNumber(va_arg(args, uint32_t), 10, false, width, pad);
+                break;
+            case 'd':
+                value = va_arg(args, int32_t);
+                if (value < 0)
+                {
+                    putcUart0('-');
+                    value = -value;
+                }
+                logNumber(value, 10, false, width, pad);
+                break;
+            case 'x':
+            case 'X':
+                logNumber(va_arg(args, uint32_t), 16, fmt[i] == 'X', width, pad);
+                break;
+            case 'c':
+                putcUart0(va_arg(args, uint32_t));
+                break;
+            case '%':
+                putcUart0('%');
+                break;
+            default:
+                // unsupported conversion, drop it
+                if (fmt[i] == '\0')
+                    i--;
+                break;
+        }
+        i++;
+    }
+    va_end(args);
+}
@@ -0,0 +1,59 @@
+// Tokenized logging functions
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+#ifndef LOG_H_
+#define LOG_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+// 1 = send a token and varint arguments, 0 = format the text on target
+#ifndef LOG_TOKENIZED
+#define LOG_TOKENIZED 1
+#endif
+
+// format strings live in the .logstr COPY section linked at this address
+// (see tm4c123gh6pm.cmd), a token is the offset of the string in that section
+#define LOG_TOKEN_BASE 0x80000000
+
+// every frame starts with a NUL so the host can tell it apart from shell text
+#define LOG_FRAME_START 0x00
+#define LOG_MAX_ARGS    6
+
+// counts the arguments after the format string (0 to LOG_MAX_ARGS)
+#define LOG_ARGC(...) LOG_ARGC_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_ARGC_(_0, _1, _2, _3, _4, _5, _6, N, ...) N
+
+// LOG("fmt", args...)
+// only integer conversions are supported: %u %d %x %X %c and %%,
+// with an optional 0 flag and width (eg. 0x%08X)
+#if LOG_TOKENIZED
+#define LOG(fmt, ...)                                                                  \
+    do                                                                                 \
+    {                                                                                  \
+        static const char logFmt[] __attribute__((section(".logstr"), used)) = fmt;    \
+        logTokenized((uint32_t)logFmt - LOG_TOKEN_BASE, LOG_ARGC(__VA_ARGS__), ##__VA_ARGS__); \
+    } while (0)
+#else
+#define LOG(fmt, ...) logText(fmt, LOG_ARGC(__VA_ARGS__), ##__VA_ARGS__)
+#endif
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint8_t putVarint(uint8_t buf[], uint32_t value);
+void logTokenized(uint32_t token, uint8_t argc, ...);
+void logText(const char fmt[], uint8_t argc, ...);
+
+#endif
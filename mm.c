@@ -19,6 +19,7 @@
 #include "uartio.h"
 #include "kernel.h"
 #include "mm.h"
+#include "log.h"
 
 uint32_t *addrTable[MAX_TASKS];
 uint16_t sizeTable[MAX_TASKS];
@@ -38,14 +39,14 @@ void * mallocFromHeap(uint32_t size_in_bytes)
     int8_t i = 0;
     void *ptr = (uint32_t *)0x20001000;
 
-    while ((pid <= MAX_TASKS) && addrTable[pid])
+    while ((pid < MAX_TASKS) && addrTable[pid])
         pid++;
 
 
-    if (pid > MAX_TASKS)
-        putsUart0("Too many tasks running, free before creating new task\n\n");
+    if (pid == MAX_TASKS)
+        LOG("Too many tasks running, free before creating new task\n\n");
     else if (size_in_bytes > 24576 || size_in_bytes == 0)
-        putsUart0("Cannot allocate 0B or anything above 24576B\n\n");
+        LOG("Cannot allocate 0B or anything above 24576B\n\n");
     else
     {
         if (size_in_bytes <= 512)
@@ -58,25 +59,21 @@ void * mallocFromHeap(uint32_t size_in_bytes)
         }
 
         // looks through all the pids to make sure none are using this address
-        while (i <= MAX_TASKS)
+        // freed allocations leave holes, so start over whenever ptr moves
+        while (i < MAX_TASKS)
         {
 
-            // checks if ptr is within the current pid's region
-            if (((uint32_t)addrTable[i] <= (uint32_t)ptr) &&
-                    ((uint32_t)ptr < ((uint32_t)addrTable[i] + sizeTable[i])) ||
-                    ((uint32_t)addrTable[i] <= (uint32_t)ptr + size_in_bytes) &&
-                    ((uint32_t)ptr + size_in_bytes < ((uint32_t)addrTable[i] + sizeTable[i])))
+            // checks if ptr overlaps the current pid's region
+            if (addrTable[i] && ((uint32_t)addrTable[i] < (uint32_t)ptr + size_in_bytes) &&
+                    ((uint32_t)ptr < ((uint32_t)addrTable[i] + sizeTable[i])))
             {
                 // if so, move the ptr pointer to the end of the current pid
                 ptr = (uint32_t *)((uint32_t)addrTable[i] + sizeTable[i]);
 
                 // if the 512 MPU is full, make any 512 allocation 1024
                 if (size_in_bytes == 512 && ((uint32_t)ptr == 0x20002000))
-                {
                     size_in_bytes = 1024;
-                    ptr = (uint32_t *)0x20002000;
-                    i = -1;
-                }
+                i = -1;
             }
             i++;
         }
@@ -99,7 +96,7 @@ void * mallocFromHeap(uint32_t size_in_bytes)
         }
         else
         {
-            putsUart0("Task is either too large or not enough memory left\n\n");
+            LOG("Task is either too large or not enough memory left\n\n");
             ptr = 0x0;
         }
     }
@@ -107,6 +104,24 @@ void * mallocFromHeap(uint32_t size_in_bytes)
     return ptr;
 }
 
+// Returns the allocation p points into to the heap
+bool freeToHeap(void *p)
+{
+    uint8_t pid;
+
+    for (pid = 0; pid < MAX_TASKS; pid++)
+    {
+        if (addrTable[pid] && (uint32_t)addrTable[pid] <= (uint32_t)p
+                && (uint32_t)p < (uint32_t)addrTable[pid] + sizeTable[pid])
+        {
+            addrTable[pid] = 0;
+            sizeTable[pid] = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
 // REQUIRED: add your custom MPU functions here (eg to return the srd bits)
 void setupAllAccess(void)
 {
@@ -248,7 +263,7 @@ void generateSramSrdMasks(uint8_t srdMask[NUM_SRAM_REGIONS], void *p, uint32_t s
         */
     }
     else
-        putsUart0("No\n\n");
+        LOG("No\n\n");
 }
 
 void applySramSrdMasks(uint8_t srdMask[NUM_SRAM_REGIONS])
@@ -262,3 +277,34 @@ void applySramSrdMasks(uint8_t srdMask[NUM_SRAM_REGIONS])
         NVIC_MPU_ATTR_R |= (srdMask[i] << 8);
     }
 }
+
+// Returns true if every byte of p to p + size_in_bytes - 1 lies in a subregion
+// srdMask gives a task access to (the first 4 KiB belong to the OS)
+bool isSramAccessible(uint8_t srdMask[NUM_SRAM_REGIONS], const void *p, uint32_t size_in_bytes)
+{
+    uint32_t addr = (uint32_t)p;
+    uint32_t end = addr + size_in_bytes;
+    uint32_t scale;
+    uint8_t region;
+    bool ok = size_in_bytes && addr >= 0x20001000 && end <= 0x20008000 && end > addr;
+
+    while (ok && addr < end)
+    {
+        // MPU 2 has 512 B subregions, MPUs 3 - 5 have 1 KiB ones
+        if (addr < 0x20002000)
+        {
+            region = 0;
+            scale = 512;
+            ok = srdMask[region] & (1 << ((addr - 0x20001000) / scale));
+        }
+        else
+        {
+            region = (addr - 0x20002000) / 0x2000 + 1;
+            scale = 1024;
+            ok = srdMask[region] & (1 << (((addr - 0x20002000) % 0x2000) / scale));
+        }
+        addr = (addr & ~(scale - 1)) + scale;
+    }
+
+    return ok;
+}
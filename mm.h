@@ -16,6 +16,7 @@
 //-----------------------------------------------------------------------------
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #define NUM_SRAM_REGIONS 4
 
@@ -24,6 +25,7 @@
 //-----------------------------------------------------------------------------
 
 void * mallocFromHeap(uint32_t size_in_bytes);
+bool freeToHeap(void *p);
 void setupAllAccess(void);
 void allowFlashAccess(void);
 void allowPeripheralAccess(void);
@@ -31,5 +33,6 @@ void setupSramAccess(void);
 void initMpu(void);
 void generateSramSrdMasks(uint8_t srdMask[NUM_SRAM_REGIONS], void *p, uint32_t size_in_bytes);
 void applySramSrdMasks(uint8_t srdMask[NUM_SRAM_REGIONS]);
+bool isSramAccessible(uint8_t srdMask[NUM_SRAM_REGIONS], const void *p, uint32_t size_in_bytes);
 
 #endif
@@ -0,0 +1,76 @@
+// Board support functions for QEMU
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: QEMU mps2-an386 (Cortex-M4 with FPU and MPU)
+// System Clock:    25 MHz
+
+// Hardware configuration:
+// CMSDK APB timer 0 (0x40000000):
+//   32-bit down counter at the system clock, used as the cycle counter and
+//   for now_us(), which therefore wraps after 171 s
+// The AN386 interrupt lines do not match the TM4C vector table, so there is
+// no microsecond alarm, usleep() is woken by SysTick at 1 ms resolution
+// Semihosting:
+//   exitBoard() ends the emulator (run QEMU with -semihosting)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board.h"
+#include "mps2.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Starts timer 0 free running from 0xFFFFFFFF
+void initCycleCounter(void)
+{
+    TIMER0_CTRL_R = 0;
+    TIMER0_RELOAD_R = 0xFFFFFFFF;
+    TIMER0_VALUE_R = 0xFFFFFFFF;
+    TIMER0_CTRL_R = TIMER_CTRL_EN;
+}
+
+// Returns the running cycle count, callable from tasks
+uint32_t readCycleCounter(void)
+{
+    return ~TIMER0_VALUE_R;
+}
+
+// Timer 0 is started by initCycleCounter
+void initMicroTimer(void)
+{
+}
+
+uint64_t now_us(void)
+{
+    return readCycleCounter() / (BOARD_CLOCK_HZ / 1000000);
+}
+
+// SysTick checks the alarm instead
+bool setMicroAlarm(uint64_t us)
+{
+    return true;
+}
+
+void stopMicroAlarm(void)
+{
+}
+
+// Semihosting SYS_EXIT (0x18) with ADP_Stopped_ApplicationExit, QEMU exits
+// with status 0. Without -semihosting the BKPT escalates to a hard fault.
+void exitBoard(void)
+{
+    __asm("    MOVS R0, #0x18\n"
+          "    MOVW R1, #0x0026\n"
+          "    MOVT R1, #0x0002\n"
+          "    BKPT #0xAB");
+}
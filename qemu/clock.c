@@ -0,0 +1,25 @@
+// Clock Library for QEMU
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: QEMU mps2-an386 (Cortex-M4 with FPU and MPU)
+// System Clock:    25 MHz
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include "clock.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// The AN386 system clock is fixed at BOARD_CLOCK_HZ, there is no PLL to set up
+void initSystemClockTo40Mhz(void)
+{
+}
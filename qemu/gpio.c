@@ -0,0 +1,162 @@
+// GPIO Library for QEMU
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: QEMU mps2-an386 (Cortex-M4 with FPU and MPU)
+// System Clock:    25 MHz
+
+// The AN386 has no GPIO at the TM4C addresses (UART0 sits where port A
+// would be), so pins are kept in memory: outputs read back what was written
+// and inputs read high, like the pulled-up pushbuttons with nothing pressed.
+// The pin state lives above the 32 KiB of SRAM covered by the MPU regions,
+// so unprivileged tasks can drive the LEDs just like on the real board.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gpio.h"
+
+#define PORTS 6
+
+#pragma NOINIT(pinValues)
+#pragma LOCATION(pinValues, 0x20008000)
+uint8_t pinValues[PORTS];
+#pragma NOINIT(pinOutputs)
+#pragma LOCATION(pinOutputs, 0x20008008)
+uint8_t pinOutputs[PORTS];
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint8_t getPortIndex(PORT port)
+{
+    switch (port)
+    {
+        case PORTA: return 0;
+        case PORTB: return 1;
+        case PORTC: return 2;
+        case PORTD: return 3;
+        case PORTE: return 4;
+        default:    return 5;
+    }
+}
+
+void enablePort(PORT port)
+{
+    pinValues[getPortIndex(port)] = 0xFF;
+}
+
+void disablePort(PORT port)
+{
+}
+
+void selectPinPushPullOutput(PORT port, uint8_t pin)
+{
+    pinOutputs[getPortIndex(port)] |= 1 << pin;
+}
+
+void selectPinOpenDrainOutput(PORT port, uint8_t pin)
+{
+    pinOutputs[getPortIndex(port)] |= 1 << pin;
+}
+
+void selectPinDigitalInput(PORT port, uint8_t pin)
+{
+    pinOutputs[getPortIndex(port)] &= ~(1 << pin);
+}
+
+void selectPinAnalogInput(PORT port, uint8_t pin)
+{
+    pinOutputs[getPortIndex(port)] &= ~(1 << pin);
+}
+
+void setPinCommitControl(PORT port, uint8_t pin)
+{
+}
+
+void enablePinPullup(PORT port, uint8_t pin)
+{
+}
+
+void disablePinPullup(PORT port, uint8_t pin)
+{
+}
+
+void enablePinPulldown(PORT port, uint8_t pin)
+{
+}
+
+void disablePinPulldown(PORT port, uint8_t pin)
+{
+}
+
+void setPinAuxFunction(PORT port, uint8_t pin, uint32_t fn)
+{
+}
+
+void selectPinInterruptRisingEdge(PORT port, uint8_t pin)
+{
+}
+
+void selectPinInterruptFallingEdge(PORT port, uint8_t pin)
+{
+}
+
+void selectPinInterruptBothEdges(PORT port, uint8_t pin)
+{
+}
+
+void selectPinInterruptHighLevel(PORT port, uint8_t pin)
+{
+}
+
+void selectPinInterruptLowLevel(PORT port, uint8_t pin)
+{
+}
+
+void enablePinInterrupt(PORT port, uint8_t pin)
+{
+}
+
+void disablePinInterrupt(PORT port, uint8_t pin)
+{
+}
+
+void clearPinInterrupt(PORT port, uint8_t pin)
+{
+}
+
+void setPinValue(PORT port, uint8_t pin, bool value)
+{
+    if (value)
+        pinValues[getPortIndex(port)] |= 1 << pin;
+    else
+        pinValues[getPortIndex(port)] &= ~(1 << pin);
+}
+
+void togglePinValue(PORT port, uint8_t pin)
+{
+    pinValues[getPortIndex(port)] ^= 1 << pin;
+}
+
+bool getPinValue(PORT port, uint8_t pin)
+{
+    return pinValues[getPortIndex(port)] & (1 << pin);
+}
+
+void setPortValue(PORT port, uint8_t value)
+{
+    pinValues[getPortIndex(port)] = value;
+}
+
+uint8_t getPortValue(PORT port)
+{
+    return pinValues[getPortIndex(port)];
+}
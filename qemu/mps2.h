@@ -0,0 +1,40 @@
+// MPS2 AN386 peripheral registers
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: QEMU mps2-an386 (Cortex-M4 with FPU and MPU)
+// System Clock:    25 MHz
+
+// Only the CMSDK APB peripherals used by the QEMU board files are listed.
+// The core peripherals (SysTick, NVIC, SCB, MPU) are the same as on the
+// TM4C123GH6PM, so the kernel keeps using tm4c123gh6pm.h for those.
+
+#ifndef MPS2_H_
+#define MPS2_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+// CMSDK APB timer 0
+#define TIMER0_CTRL_R       (*((volatile uint32_t *)0x40000000))
+#define TIMER0_VALUE_R      (*((volatile uint32_t *)0x40000004))
+#define TIMER0_RELOAD_R     (*((volatile uint32_t *)0x40000008))
+#define TIMER_CTRL_EN       0x00000001
+
+// CMSDK APB UART 0 (the QEMU serial0 / -nographic console)
+#define UART0_DATA_R        (*((volatile uint32_t *)0x40004000))
+#define UART0_STATE_R       (*((volatile uint32_t *)0x40004004))
+#define UART0_CTRL_R        (*((volatile uint32_t *)0x40004008))
+#define UART0_BAUDDIV_R     (*((volatile uint32_t *)0x40004010))
+#define UART_STATE_TXFULL   0x00000001
+#define UART_STATE_RXFULL   0x00000002
+#define UART_CTRL_TXEN      0x00000001
+#define UART_CTRL_RXEN      0x00000002
+
+#endif
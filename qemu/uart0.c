@@ -0,0 +1,72 @@
+// UART0 Library for QEMU
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: QEMU mps2-an386 (Cortex-M4 with FPU and MPU)
+// System Clock:    25 MHz
+
+// Hardware configuration:
+// UART Interface:
+//   CMSDK APB UART 0, connected to the QEMU console with -nographic
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "mps2.h"
+#include "kernel.h"
+#include "uart0.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Initialize UART0
+void initUart0()
+{
+    setUart0BaudRate(115200, 25000000);
+}
+
+// Set baud rate as function of instruction cycle frequency
+void setUart0BaudRate(uint32_t baudRate, uint32_t fcyc)
+{
+    UART0_CTRL_R = 0;                                   // turn-off UART0 to allow safe programming
+    UART0_BAUDDIV_R = fcyc / baudRate;                  // QEMU ignores the rate, but wants >= 16
+    UART0_CTRL_R = UART_CTRL_TXEN | UART_CTRL_RXEN;     // enable TX and RX
+}
+
+// Blocking function that writes a serial character when the UART buffer is not full
+void putcUart0(char c)
+{
+    while (UART0_STATE_R & UART_STATE_TXFULL);          // wait if uart0 tx buffer full
+    UART0_DATA_R = c;
+}
+
+// Blocking function that writes a string when the UART buffer is not full
+void putsUart0(char* str)
+{
+    uint8_t i = 0;
+    while (str[i] != '\0')
+        putcUart0(str[i++]);
+}
+
+// Blocking function that returns with serial data once the buffer is not empty
+char getcUart0()
+{
+    while (!(UART0_STATE_R & UART_STATE_RXFULL))        // wait if uart0 rx buffer empty
+    {
+        yield();
+    }
+    return UART0_DATA_R & 0xFF;
+}
+
+// Returns the status of the receive buffer
+bool kbhitUart0()
+{
+    return UART0_STATE_R & UART_STATE_RXFULL;
+}
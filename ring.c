@@ -0,0 +1,116 @@
+// Single-producer single-consumer ring buffer functions
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// The M4 has no data cache, so there are no cache lines to keep the two
+// indices apart on; they only need to be single-writer words. A DMB orders
+// the data copy before the index store that publishes (or frees) it.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "kernel.h"
+#include "ring.h"
+
+#ifdef RTOS_SIM
+#define ringBarrier() __sync_synchronize()
+#else
+#define ringBarrier() __asm("    DMB")
+#endif
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Sets up an empty ring, capacity must be a power of two (up to 32 KiB)
+// semaphore is posted when a push makes the ring non-empty, NO_OBJECT for none
+bool initRing(RING *ring, uint16_t capacity, uint8_t semaphore)
+{
+    bool ok = (capacity && capacity <= 0x8000 && !(capacity & (capacity - 1)));
+    if (ok)
+    {
+        ring->head = 0;
+        ring->tail = 0;
+        ring->mask = capacity - 1;
+        ring->semaphore = semaphore;
+    }
+    return ok;
+}
+
+uint16_t getRingCount(RING *ring)
+{
+    return (uint16_t)(ring->head - ring->tail);
+}
+
+// Copies up to count bytes in, returns the bytes that fit
+// Sets *wasEmpty if the ring was empty before, the caller wakes the consumer
+uint16_t copyIntoRing(RING *ring, const uint8_t data[], uint16_t count, bool *wasEmpty)
+{
+    uint16_t head = ring->head;
+    uint16_t used = (uint16_t)(head - ring->tail);
+    uint16_t room = ring->mask + 1 - used;
+    uint16_t i;
+
+    if (count > room)
+        count = room;
+    for (i = 0; i < count; i++)
+        ring->data[(uint16_t)(head + i) & ring->mask] = data[i];
+
+    ringBarrier();
+    ring->head = head + count;
+    *wasEmpty = (used == 0 && count);
+    return count;
+}
+
+// Producer side for a task
+uint16_t pushRing(RING *ring, const uint8_t data[], uint16_t count)
+{
+    bool wasEmpty;
+
+    count = copyIntoRing(ring, data, count, &wasEmpty);
+    if (wasEmpty && ring->semaphore != NO_OBJECT)
+        post(ring->semaphore);
+    return count;
+}
+
+// Producer side for an interrupt handler (see postFromIsr)
+uint16_t pushRingFromIsr(RING *ring, const uint8_t data[], uint16_t count)
+{
+    bool wasEmpty;
+
+    count = copyIntoRing(ring, data, count, &wasEmpty);
+    if (wasEmpty && ring->semaphore != NO_OBJECT)
+        postFromIsr(ring->semaphore);
+    return count;
+}
+
+// Copies up to count bytes out without blocking, returns the bytes read
+// (0 when the ring is empty)
+// With a semaphore, the caller waits on it after a 0 and calls again, a
+// stale post only costs it an extra pass
+uint16_t popRing(RING *ring, uint8_t data[], uint16_t count)
+{
+    uint16_t tail = ring->tail;
+    uint16_t used = (uint16_t)(ring->head - tail);
+    uint16_t i;
+
+    if (count > used)
+        count = used;
+
+    ringBarrier();
+    for (i = 0; i < count; i++)
+        data[i] = ring->data[(uint16_t)(tail + i) & ring->mask];
+
+    ringBarrier();
+    ring->tail = tail + count;
+    return count;
+}
@@ -0,0 +1,52 @@
+// Single-producer single-consumer ring buffer functions
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// One producer (a task or an interrupt handler) and one consumer task move
+// bytes through the ring without an SVC per byte. Each index is written by
+// one side only, so a barrier between the data and the index update is all
+// the synchronization needed. The ring has to sit in memory both sides can
+// reach: a message block shared with shareBlock() for two tasks, or the
+// consumer's memory when the producer is a handler.
+
+#ifndef RING_H_
+#define RING_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// the indices run freely and are masked on access, so a full ring is
+// head - tail == capacity
+typedef struct _RING
+{
+    volatile uint16_t head;        // next byte to write, producer only
+    volatile uint16_t tail;        // next byte to read, consumer only
+    uint16_t mask;                 // capacity - 1
+    uint8_t semaphore;             // posted when the ring stops being empty, NO_OBJECT if none
+    uint8_t data[];
+} RING;
+
+// bytes of memory a ring of capacity bytes needs
+#define RING_BYTES(capacity) (sizeof(RING) + (capacity))
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+bool initRing(RING *ring, uint16_t capacity, uint8_t semaphore);
+uint16_t getRingCount(RING *ring);
+uint16_t pushRing(RING *ring, const uint8_t data[], uint16_t count);
+uint16_t pushRingFromIsr(RING *ring, const uint8_t data[], uint16_t count);
+uint16_t popRing(RING *ring, uint8_t data[], uint16_t count);
+
+#endif
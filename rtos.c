@@ -39,6 +39,8 @@
 #include "faults.h"
 #include "tasks.h"
 #include "shell.h"
+#include "board.h"
+#include "bench.h"
 
 //-----------------------------------------------------------------------------
 // Main
@@ -55,29 +57,38 @@ int main(void){
     initRtos();
 
     // Setup UART0 baud rate
-    setUart0BaudRate(115200, 40e6);
+    setUart0BaudRate(115200, BOARD_CLOCK_HZ);
 
+#ifdef RTOS_BENCH
+    // Benchmark task set (bench.c) instead of the demo tasks
+    ok = initBench();
+#else
     // Initialize mutexes and semaphores
     initMutex(resource);
     initSemaphore(keyPressed, 1);
     initSemaphore(keyReleased, 0);
     initSemaphore(flashReq, 5);
+    initEventGroup(keyEvents);
 
-    // Add required idle process at lowest priority
-    ok = createThread(idle, "Idle", 7, 512);
-    // ok = createThread(idle2, "Idle2", 7, 512);
+    // Work task for the deferred part of interrupt handlers
+    ok = initWorkQueue(1, 512);
+
+    // The idle task (created by initRtos) flickers the orange LED
+    setIdleHook(idleLed);
+    // ok &= createThread(idle2, "Idle2", 7, 512) != NO_THREAD;
 
 
     // Add other processes
-    ok &= createThread(lengthyFn, "LengthyFn", 6, 1024);
-    ok &= createThread(flash4Hz, "Flash4Hz", 4, 1024);
-    ok &= createThread(oneshot, "OneShot", 2, 1024);
-    ok &= createThread(readKeys, "ReadKeys", 6, 1024);
-    ok &= createThread(debounce, "Debounce", 6, 1024);
-    ok &= createThread(important, "Important", 0, 1024);
-    ok &= createThread(uncooperative, "Uncoop", 6, 1024);
-    ok &= createThread(errant, "Errant", 6, 1024);
-    ok &= createThread(shell, "Shell", 6, 4096);
+    ok &= createThread(lengthyFn, "LengthyFn", 6, 1024) != NO_THREAD;
+    ok &= createThread(flash4Hz, "Flash4Hz", 4, 1024) != NO_THREAD;
+    ok &= createThread(oneshot, "OneShot", 2, 1024) != NO_THREAD;
+    ok &= createThread(readKeys, "ReadKeys", 6, 1024) != NO_THREAD;
+    ok &= createThread(debounce, "Debounce", 6, 1024) != NO_THREAD;
+    ok &= createThread(important, "Important", 0, 1024) != NO_THREAD;
+    ok &= createThread(uncooperative, "Uncoop", 6, 1024) != NO_THREAD;
+    ok &= createThread(errant, "Errant", 6, 1024) != NO_THREAD;
+    ok &= createThread(shell, "Shell", 6, 4096) != NO_THREAD;
+#endif
 
 
     // Start up RTOS
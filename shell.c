@@ -41,6 +41,8 @@ void printHelp(void)
     putsUart0(" preempt ON|OFF\t\tTurns preemption on or off\n");
     // sched
     putsUart0(" sched PRIO|RR\t\tSelected ity or round-robin scheduling\n");
+    // pi
+    putsUart0(" pi ON|OFF\t\tTurns priority inheritance on or off\n");
     // pidof
     putsUart0(" pidof proc_name\tDisplays the PID of the process (thread)\n");
     // run
@@ -51,6 +53,8 @@ void printHelp(void)
     putsUart0(" free address\t\tFrees memory based on base hex address of a sub-region\n");
     // dm
     putsUart0(" dm\t\t\tDisplays the current memory addresses and their sizes\n");
+    // trace
+    putsUart0(" trace\t\t\tDumps the kernel event trace (decode with tools/trace2json.py)\n");
     // clr
     putsUart0(" clr\t\t\tClears terminal window\n");
     // help
@@ -68,15 +72,45 @@ void ps(void)
 
     for (task = 0; task < 12; task++)
     {
+        if (!ps_data.pid[task])
+            continue;
         putsUart0(ps_data.name[task]);
         putsUart0("\t\t");
         putsUart0(IntToString(ps_data.pid[task], buf));
-        putsUart0("\n");
+        putsUart0("\t");
+        putsUart0(IntToString(ps_data.switches[task], buf));
+        putsUart0(" switches, quantum ");
+        putsUart0(IntToString(ps_data.quantum[task], buf));
+        putsUart0(" ms used up ");
+        putsUart0(IntToString(ps_data.sliceEnds[task], buf));
+        putsUart0(" times\n");
     }
 
+    // cpu load since boot, from the time the idle task got
+    putsUart0("CPU load ");
+    if (ps_data.upTime)
+        putsUart0(IntToString(100 - (uint32_t)((uint64_t)ps_data.idleTime * 100 / ps_data.upTime), buf));
+    else
+        putsUart0("0");
+    putsUart0("%, idle ");
+    putsUart0(IntToString(ps_data.idleTime, buf));
+    putsUart0(" of ");
+    putsUart0(IntToString(ps_data.upTime, buf));
+    putsUart0(" ms\n");
+
     putsUart0("ps called\n");
 }
 
+// Writes the kernel event trace (trace.h) from a copy, the kernel only
+// takes part for the copy
+void dumpTrace(void)
+{
+    TRACE_DATA trace;
+
+    copyTrace(&trace);
+    traceWrite(&trace);
+}
+
 void ipcs(void)
 {
 
@@ -88,12 +122,39 @@ void ipcs(void)
     // getMutexInfo(&resource_data);
     // getSemaphoreInfo(&sem_data);
 
+    IPCS_RW_DATA rw_data;
+    uint8_t rw;
+
+    char buf[MAX_CHARS];
+
+    // rw locks, with how often readers and writers had to wait
+    for (rw = 0; rw < MAX_RW_LOCKS; rw++)
+    {
+        if (!getRwLockInfo(&rw_data, rw))
+            continue;
+        putsUart0("rw lock ");
+        putsUart0(IntToString(rw, buf));
+        putsUart0(":\treaders ");
+        putsUart0(IntToString(rw_data.readers, buf));
+        putsUart0(", writer ");
+        putsUart0(rw_data.writer ? rw_data.writerName : "-");
+        putsUart0(", waiting ");
+        putsUart0(IntToString(rw_data.readQueueSize, buf));
+        putsUart0("r/");
+        putsUart0(IntToString(rw_data.writeQueueSize, buf));
+        putsUart0("w, contended ");
+        putsUart0(IntToString(rw_data.readContended, buf));
+        putsUart0("r/");
+        putsUart0(IntToString(rw_data.writeContended, buf));
+        putsUart0("w\n");
+    }
+
     putsUart0("ipcs called\n");
 }
 
-void kill(uint8_t pid) // need 2 test
+void kill(uint32_t pid) // need 2 test
 {
-    stopThread((_fn)pid);
+    stopThread(pid);
 
     char buf[MAX_CHARS];
 
@@ -103,22 +164,17 @@ void kill(uint8_t pid) // need 2 test
 
 void Pkill(const char name[]) // need 2 test
 {
-    uint32_t pid = getPid(name);
+    _thread pid = getPid(name);
 
-    stopThread((_fn)pid);
+    stopThread(pid);
 
     putsUart0((char*)name);
     putsUart0(" killed\n");
 }
 
-void reboot(void) // done
-{
-    __asm("    SVC #11");
-}
-
 void pidof(const char name[]) // done
 {
-    uint32_t pid = getPid(name);
+    _thread pid = getPid(name);
 
     char buf[MAX_CHARS];
 
@@ -131,23 +187,13 @@ void pidof(const char name[]) // done
 
 void run(const char name[]) // have to test with stopThread()
 {
-    uint32_t pid = getPid(name);
-    restartThread((_fn)pid);
+    _thread pid = getPid(name);
+    restartThread(pid);
 
     putsUart0((char*)name);
     putsUart0(" now running\n");
 }
 
-void preempt(bool on) // done
-{
-    __asm("    SVC #9");
-}
-
-void sched(bool prio_on) // done
-{
-    __asm("    SVC #15");
-}
-
 // REQUIRED: add processing for the shell commands through the UART here
 void shell(void)
 {
@@ -158,7 +204,7 @@ void shell(void)
             USER_DATA data;
             clearField(&data);
 
-            uint8_t pid = 0;
+            uint32_t pid = 0;
             char* proc_name = 0;
             char* ptr = 0;
             bool valid = false;
@@ -187,6 +233,14 @@ void shell(void)
                 valid = true;
             }
 
+            if (isCommand(&data, "trace", 0))
+            {
+                dumpTrace();
+                putsUart0("\n");
+
+                valid = true;
+            }
+
             if (isCommand(&data, "kill", 1))
             {
                 pid = getFieldInteger(&data, 1);
@@ -247,6 +301,27 @@ void shell(void)
                 }
             }
 
+            if (isCommand(&data, "pi", 1))
+            {
+                ptr = getFieldString(&data, 1);
+                if (stringsEqual("ON", ptr) || stringsEqual("on", ptr))
+                {
+                    pi(true);
+                    valid = true;
+                }
+                if (stringsEqual("OFF", ptr) || stringsEqual("off", ptr))
+                {
+                    pi(false);
+                    valid = true;
+                }
+
+                if (!valid)
+                {
+                    putsUart0("Invalid priority inheritance setting, enter 'ON' or 'OFF'\n\n");
+                    valid = true;
+                }
+            }
+
             if (isCommand(&data, "pidof", 1))
             {
                 proc_name = getFieldString(&data, 1);
@@ -23,6 +23,11 @@ typedef struct _PS_DATA
 {
     uint32_t pid[12];
     char name[12][16];
+    uint32_t switches[12];         // times each task was switched in
+    uint32_t sliceEnds[12];        // times its quantum ran out and it was preempted
+    uint8_t quantum[12];           // quantum of its priority in ticks
+    uint32_t upTime;               // ms since initRtos
+    uint32_t idleTime;             // ms spent in the idle task
 } PS_DATA;
 
 typedef struct _IPCS_MUT_DATA
@@ -40,6 +45,17 @@ typedef struct _IPCS_SEM_DATA
     char queueNames[2][16];
 } IPCS_SEM_DATA;
 
+typedef struct _IPCS_RW_DATA
+{
+    uint8_t readers;
+    bool writer;
+    uint8_t readQueueSize;
+    uint8_t writeQueueSize;
+    uint16_t readContended;        // locks that had to wait since init
+    uint16_t writeContended;
+    char writerName[16];
+} IPCS_RW_DATA;
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
@@ -47,13 +63,15 @@ typedef struct _IPCS_SEM_DATA
 void printHelp(void);
 void ps(void);
 void ipcs(void);
-void kill(uint8_t pid);
+void dumpTrace(void);
+void kill(uint32_t pid);
 void Pkill(const char name[]);
 void reboot(void);
 void pidof(const char name[]);
 void run(const char name[]);
 void preempt(bool on);
 void sched(bool prio_on);
+void pi(bool on);
 void shell(void);
 
 #endif
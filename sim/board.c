@@ -0,0 +1,70 @@
+// Board support functions for the host simulation
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target:          Linux x86-64 host (simulates the TM4C123GH6PM)
+// System Clock:    40 MHz (simulated)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board.h"
+#include "sim.h"
+
+static uint64_t simAlarm = 0;           // cycle the alarm goes off at, 0 = stopped
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initCycleCounter(void)
+{
+}
+
+// Simulated cycles, only modeled costs (SVCs, switches, waits) show up here
+uint32_t readCycleCounter(void)
+{
+    return (uint32_t)simCycles;
+}
+
+void initMicroTimer(void)
+{
+}
+
+uint64_t now_us(void)
+{
+    return simCycles / SIM_CYCLES_PER_US;
+}
+
+// The core raises microTimerIsr() once simCycles reaches the alarm
+bool setMicroAlarm(uint64_t us)
+{
+    simAlarm = us * SIM_CYCLES_PER_US;
+    return simCycles < simAlarm;
+}
+
+void stopMicroAlarm(void)
+{
+    simAlarm = 0;
+}
+
+uint64_t simMicroAlarm(void)
+{
+    return simAlarm;
+}
+
+bool simMicroAlarmPending(void)
+{
+    return simAlarm && simCycles >= simAlarm;
+}
+
+void exitBoard(void)
+{
+    simExit("exit");
+}
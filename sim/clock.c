@@ -0,0 +1,25 @@
+// Clock Library for the host simulation
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target:          Linux x86-64 host (simulates the TM4C123GH6PM)
+// System Clock:    40 MHz (simulated)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include "clock.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// The simulated core always runs at SIM_CLOCK_HZ
+void initSystemClockTo40Mhz(void)
+{
+}
@@ -0,0 +1,277 @@
+// GPIO Library for the host simulation
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target:          Linux x86-64 host (simulates the TM4C123GH6PM)
+// System Clock:    40 MHz (simulated)
+
+// Keeps the value of every pin of ports A-F. Outputs can be logged to stderr
+// with -l, the six pushbuttons read back the mask set by -p ms:mask. Edges
+// on the pushbuttons latch the pin interrupt status like the GPIO RIS
+// register, and the core raises the port interrupt (level modes are not
+// modeled).
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "gpio.h"
+#include "sim.h"
+
+#define PORTS       6
+#define MAX_PRESSES 64
+
+// pushbuttons PB0-PB5 as wired in tasks.c, active low with pull-ups
+static const struct
+{
+    PORT port;
+    uint8_t pin;
+} buttons[] = {{PORTF, 3}, {PORTE, 0}, {PORTB, 7}, {PORTA, 3}, {PORTA, 2}, {PORTF, 4}};
+
+static struct
+{
+    uint32_t ms;
+    uint8_t mask;
+} presses[MAX_PRESSES];
+static uint8_t pressCount = 0;
+
+// interrupt number of each port (ports C and D are never raised)
+static const uint8_t portIrqs[PORTS] = {INT_GPIOA - 16, INT_GPIOB - 16, INT_GPIOC - 16,
+                                        INT_GPIOD - 16, INT_GPIOE - 16, INT_GPIOF - 16};
+
+static uint8_t values[PORTS];
+static uint8_t outputs[PORTS];
+static bool logOutputs = false;
+
+// pin interrupt configuration and status (IS/IBE/IEV, IM and RIS)
+static uint8_t risingEdges[PORTS];
+static uint8_t fallingEdges[PORTS];
+static uint8_t irqMasks[PORTS];
+static uint8_t irqStatus[PORTS];
+static uint8_t lastPressed = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// From ms on, the buttons in mask read as pressed (kept in time order)
+void simGpioAddButtons(uint32_t ms, uint8_t mask)
+{
+    uint8_t i;
+
+    if (pressCount == MAX_PRESSES)
+        return;
+
+    i = pressCount++;
+    while (i && presses[i - 1].ms > ms)
+    {
+        presses[i] = presses[i - 1];
+        i--;
+    }
+    presses[i].ms = ms;
+    presses[i].mask = mask;
+}
+
+void simGpioSetLog(bool on)
+{
+    logOutputs = on;
+}
+
+static uint8_t portIndex(PORT port)
+{
+    switch (port)
+    {
+        case PORTA: return 0;
+        case PORTB: return 1;
+        case PORTC: return 2;
+        case PORTD: return 3;
+        case PORTE: return 4;
+        default:    return 5;
+    }
+}
+
+static uint8_t pressed(void)
+{
+    uint8_t mask = 0;
+    uint8_t i;
+
+    for (i = 0; i < pressCount && presses[i].ms <= simMillis(); i++)
+        mask = presses[i].mask;
+    return mask;
+}
+
+// Latches the pushbutton edges since the last call and returns the exception
+// number of the first port enabled in the NVIC with an enabled pin interrupt
+// pending, 0 if there is none
+uint8_t simGpioIrqPending(void)
+{
+    uint8_t now = pressed();
+    uint8_t changed = now ^ lastPressed;
+    uint8_t i;
+    uint8_t port;
+    uint8_t bit;
+
+    // a press pulls the pin low
+    for (i = 0; changed && i < sizeof(buttons) / sizeof(buttons[0]); i++)
+    {
+        if (!(changed & (1 << i)))
+            continue;
+        port = portIndex(buttons[i].port);
+        bit = 1 << buttons[i].pin;
+        if ((now & (1 << i)) ? (fallingEdges[port] & bit) : (risingEdges[port] & bit))
+            irqStatus[port] |= bit;
+    }
+    lastPressed = now;
+
+    for (port = 0; port < PORTS; port++)
+        if ((irqStatus[port] & irqMasks[port]) && (NVIC_EN0_R & (1 << portIrqs[port])))
+            return portIrqs[port] + 16;
+    return 0;
+}
+
+void enablePort(PORT port)
+{
+}
+
+void disablePort(PORT port)
+{
+}
+
+void selectPinPushPullOutput(PORT port, uint8_t pin)
+{
+    outputs[portIndex(port)] |= 1 << pin;
+}
+
+void selectPinOpenDrainOutput(PORT port, uint8_t pin)
+{
+    outputs[portIndex(port)] |= 1 << pin;
+}
+
+void selectPinDigitalInput(PORT port, uint8_t pin)
+{
+    outputs[portIndex(port)] &= ~(1 << pin);
+}
+
+void selectPinAnalogInput(PORT port, uint8_t pin)
+{
+    outputs[portIndex(port)] &= ~(1 << pin);
+}
+
+void setPinCommitControl(PORT port, uint8_t pin)
+{
+}
+
+void enablePinPullup(PORT port, uint8_t pin)
+{
+}
+
+void disablePinPullup(PORT port, uint8_t pin)
+{
+}
+
+void enablePinPulldown(PORT port, uint8_t pin)
+{
+}
+
+void disablePinPulldown(PORT port, uint8_t pin)
+{
+}
+
+void setPinAuxFunction(PORT port, uint8_t pin, uint32_t fn)
+{
+}
+
+void selectPinInterruptRisingEdge(PORT port, uint8_t pin)
+{
+    risingEdges[portIndex(port)] |= 1 << pin;
+    fallingEdges[portIndex(port)] &= ~(1 << pin);
+}
+
+void selectPinInterruptFallingEdge(PORT port, uint8_t pin)
+{
+    risingEdges[portIndex(port)] &= ~(1 << pin);
+    fallingEdges[portIndex(port)] |= 1 << pin;
+}
+
+void selectPinInterruptBothEdges(PORT port, uint8_t pin)
+{
+    risingEdges[portIndex(port)] |= 1 << pin;
+    fallingEdges[portIndex(port)] |= 1 << pin;
+}
+
+void selectPinInterruptHighLevel(PORT port, uint8_t pin)
+{
+    risingEdges[portIndex(port)] &= ~(1 << pin);
+    fallingEdges[portIndex(port)] &= ~(1 << pin);
+}
+
+void selectPinInterruptLowLevel(PORT port, uint8_t pin)
+{
+    selectPinInterruptHighLevel(port, pin);
+}
+
+void enablePinInterrupt(PORT port, uint8_t pin)
+{
+    irqMasks[portIndex(port)] |= 1 << pin;
+}
+
+void disablePinInterrupt(PORT port, uint8_t pin)
+{
+    irqMasks[portIndex(port)] &= ~(1 << pin);
+}
+
+void clearPinInterrupt(PORT port, uint8_t pin)
+{
+    irqStatus[portIndex(port)] &= ~(1 << pin);
+}
+
+void setPinValue(PORT port, uint8_t pin, bool value)
+{
+    uint8_t i = portIndex(port);
+    uint8_t old = values[i];
+
+    simAdvance(SIM_GPIO_CYCLES);
+    if (value)
+        values[i] |= 1 << pin;
+    else
+        values[i] &= ~(1 << pin);
+
+    if (logOutputs && old != values[i])
+        fprintf(stderr, "%10.3f ms  P%c%u = %u\n", simCycles / (SIM_CLOCK_HZ / 1000.0), 'A' + i, pin, value);
+}
+
+void togglePinValue(PORT port, uint8_t pin)
+{
+    setPinValue(port, pin, !(values[portIndex(port)] & (1 << pin)));
+}
+
+bool getPinValue(PORT port, uint8_t pin)
+{
+    uint8_t i;
+
+    simAdvance(SIM_GPIO_CYCLES);
+    for (i = 0; i < sizeof(buttons) / sizeof(buttons[0]); i++)
+        if (buttons[i].port == port && buttons[i].pin == pin)
+            return !(pressed() & (1 << i));
+
+    return values[portIndex(port)] & (1 << pin);
+}
+
+void setPortValue(PORT port, uint8_t value)
+{
+    simAdvance(SIM_GPIO_CYCLES);
+    values[portIndex(port)] = value;
+}
+
+uint8_t getPortValue(PORT port)
+{
+    simAdvance(SIM_GPIO_CYCLES);
+    return values[portIndex(port)];
+}
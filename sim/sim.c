@@ -0,0 +1,586 @@
+// Host simulation core
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target:          Linux x86-64 host (simulates the TM4C123GH6PM)
+// System Clock:    40 MHz (simulated)
+
+// Usage: rtos-sim [-t ms] [-p ms:mask]... [-s ms:text]... [-i] [-l] [-T file]
+//   -t ms       stop after ms of simulated time (default 5000, 0 = never)
+//   -p ms:mask  from ms on, readPbs() returns mask (0 releases every button)
+//   -s ms:text  type text and a carriage return into UART0 at ms
+//   -i          also feed stdin to UART0 as it arrives (not deterministic)
+//   -l          log every GPIO output change to stderr
+//   -T file     write a kernel trace dump (tools/trace2json.py) at exit
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <signal.h>
+#include <ucontext.h>
+#include <getopt.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "tm4c123gh6pm.h"
+#include "mm.h"
+#include "faults.h"
+#include "trace.h"
+#include "sim.h"
+
+// kernel.h is not included, kill() and sleep() clash with the C library
+
+// rtos.c is built with main renamed
+int rtosMain(void);
+
+// kernel entry points (kernel.c)
+void systickIsr(void);
+void pendSvIsr(void);
+void svCallIsr(void);
+void microTimerIsr(void);
+
+// pushbutton handler (tasks.c), in the vector table of GPIO ports A, B, E and F
+void pbIsr(void);
+
+// mm.c version, reached through -Wl,--wrap=applySramSrdMasks
+void __real_applySramSrdMasks(uint8_t srdMask[NUM_SRAM_REGIONS]);
+bool __real_isSramAccessible(uint8_t srdMask[NUM_SRAM_REGIONS], const void *p, uint32_t size_in_bytes);
+
+// one task context per 512 B SRAM block, keyed by the top of the task stack
+#define SIM_SLOTS        (SIM_SRAM_SIZE / 512)
+#define SIM_STACK_SIZE   0x10000
+
+// the slot number is stashed in the stacked R12 of every exception frame
+#define SIM_FRAME_TAG    0x51D00000
+#define SIM_FRAME_TAG_M  0xFFFF0000
+
+#define XPSR_VALID       0x01000000
+#define XPSR_ALIGNED     0x00000200  // frame was realigned to 8 bytes
+#define EXC_RETURN_PSP   0xFFFFFFFD
+
+typedef struct _SIM_SLOT
+{
+    ucontext_t ctx;
+    void *pc;
+} SIM_SLOT;
+
+uint64_t simCycles = 0;
+uint32_t simPsp = 0;
+SIM_STATS simStats;
+
+static SIM_SLOT simSlots[SIM_SLOTS];
+static uint8_t simStacks[SIM_SLOTS][SIM_STACK_SIZE];
+static uint8_t simKernelStack[SIM_STACK_SIZE];
+static ucontext_t simKernelCtx;
+static uint8_t simCurrent = 0;          // slot of the running task
+static uint8_t simException = 0;        // exception the kernel context services next
+static bool simHandler = true;          // handler mode (or privileged, before startRtos)
+static bool simTickPending = false;
+static bool simExiting = false;
+static uint64_t simNextTick = 0;
+static uint64_t simEnd = 5000ULL * SIM_CLOCK_HZ / 1000;
+static uint8_t simSrd[NUM_SRAM_REGIONS];
+static int simPageProt[SIM_SRAM_SIZE / 0x1000];
+static const char *simTraceFile = NULL;
+
+// "SVC #n" encodings, the stacked PC of an SVC points just past one of these
+static uint16_t simSvcInsn[256 + 2];
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+static void simCount(uint64_t cycles)
+{
+    simCycles += cycles;
+    if (DWT_CTRL_R & DWT_CTRL_CYCCNTENA)
+        DWT_CYCCNT_R += cycles;
+}
+
+uint32_t simMillis(void)
+{
+    return simCycles / (SIM_CLOCK_HZ / 1000);
+}
+
+// True if unprivileged code may touch addr with the current SRD masks
+static bool simSramAllowed(uint32_t addr)
+{
+    if (addr < SIM_SRAM_BASE + 0x1000 || addr >= SIM_SRAM_BASE + SIM_SRAM_SIZE)
+        return false;
+    if (addr < SIM_SRAM_BASE + 0x2000)
+        return simSrd[0] & (1 << ((addr - (SIM_SRAM_BASE + 0x1000)) / 512));
+    addr -= SIM_SRAM_BASE + 0x2000;
+    return simSrd[1 + addr / 0x2000] & (1 << ((addr % 0x2000) / 1024));
+}
+
+// Page granular stand-in for the MPU: a 4 KiB page is accessible to a task
+// if any of its subregions is, exception frames are checked exactly
+static void simApplyMpu(bool privileged)
+{
+    uint8_t page;
+    uint32_t addr;
+    int prot;
+    bool mpu = NVIC_MPU_CTRL_R & NVIC_MPU_CTRL_ENABLE;
+
+    for (page = 0; page < SIM_SRAM_SIZE / 0x1000; page++)
+    {
+        prot = PROT_READ | PROT_WRITE;
+        if (mpu && !privileged)
+        {
+            prot = PROT_NONE;
+            for (addr = 0; addr < 0x1000; addr += 512)
+                if (simSramAllowed(SIM_SRAM_BASE + page * 0x1000 + addr))
+                    prot = PROT_READ | PROT_WRITE;
+        }
+        if (prot != simPageProt[page])
+        {
+            mprotect((void *)(uintptr_t)(SIM_SRAM_BASE + page * 0x1000), 0x1000, prot);
+            simPageProt[page] = prot;
+        }
+    }
+}
+
+void __wrap_applySramSrdMasks(uint8_t srdMask[NUM_SRAM_REGIONS])
+{
+    __real_applySramSrdMasks(srdMask);
+    memcpy(simSrd, srdMask, NUM_SRAM_REGIONS);
+}
+
+// Task locals live on host stacks and constants in the host image, so the
+// kernel's pointer checks only apply to the simulated SRAM
+bool __wrap_isSramAccessible(uint8_t srdMask[NUM_SRAM_REGIONS], const void *p, uint32_t size_in_bytes)
+{
+    if ((uintptr_t)p >= SIM_SRAM_BASE && (uintptr_t)p < SIM_SRAM_BASE + SIM_SRAM_SIZE)
+        return __real_isSramAccessible(srdMask, p, size_in_bytes);
+    return p != NULL;
+}
+
+// Exception entry stacking: R0-R3, R12, LR, PC, xPSR on the PSP
+static uint32_t *simPushFrame(uint32_t r0, uint32_t r1, uint32_t r2, uint32_t r3, uint32_t pc, uint8_t slot)
+{
+    uint32_t xpsr = XPSR_VALID;
+    uint32_t *frame;
+
+    if (simPsp & 4)
+        xpsr |= XPSR_ALIGNED;
+    simPsp = (simPsp - 32) & ~7;
+    frame = (uint32_t *)(uintptr_t)simPsp;
+
+    frame[0] = r0;
+    frame[1] = r1;
+    frame[2] = r2;
+    frame[3] = r3;
+    frame[4] = SIM_FRAME_TAG | slot;
+    frame[5] = 0;
+    frame[6] = pc;
+    frame[7] = xpsr;
+
+    return frame;
+}
+
+// Takes an exception from thread mode, returns once the task is resumed
+static uint32_t *simRaise(uint8_t exception, uint32_t r0, uint32_t r1, uint32_t r2, uint32_t r3, uint32_t pc)
+{
+    uint32_t *frame;
+
+    simHandler = true;
+    simApplyMpu(true);
+
+    if ((NVIC_MPU_CTRL_R & NVIC_MPU_CTRL_ENABLE) &&
+            (!simSramAllowed(simPsp - 32) || !simSramAllowed(simPsp - 4)))
+    {
+        // stacking into memory the task does not own
+        NVIC_FAULT_STAT_R |= NVIC_FAULT_STAT_MSTKE;
+        exception = SIM_EXC_MEMFAULT;
+    }
+    frame = simPushFrame(r0, r1, r2, r3, pc, simCurrent);
+
+    simException = exception;
+    swapcontext(&simSlots[simCurrent].ctx, &simKernelCtx);
+    return frame;
+}
+
+// Exception return: unstack the frame on the PSP and resume its task
+static void simReturn(void)
+{
+    uint32_t *frame = (uint32_t *)(uintptr_t)simPsp;
+
+    if ((frame[4] & SIM_FRAME_TAG_M) != SIM_FRAME_TAG)
+    {
+        fprintf(stderr, "sim: no exception frame at PSP 0x%08X\n", simPsp);
+        simExit("hard fault");
+    }
+    simCurrent = frame[4] & ~SIM_FRAME_TAG_M;
+    simPsp += 32 + ((frame[7] & XPSR_ALIGNED) ? 4 : 0);
+
+    simHandler = false;
+    simApplyMpu(false);
+    swapcontext(&simKernelCtx, &simSlots[simCurrent].ctx);
+}
+
+// Runs an interrupt handler with its exception number in VECACTIVE, which
+// the handler reads to tell the ports sharing it apart
+static void simIrq(uint8_t vector, void (*isr)(void))
+{
+    NVIC_INT_CTRL_R = (NVIC_INT_CTRL_R & ~NVIC_INT_CTRL_VEC_ACT_M) | vector;
+    isr();
+    NVIC_INT_CTRL_R &= ~NVIC_INT_CTRL_VEC_ACT_M;
+}
+
+// Handler mode: services one exception, tail-chains SysTick and PendSV
+static void simKernel(void)
+{
+    while (true)
+    {
+        switch (simException)
+        {
+            case SIM_EXC_SVC:
+                simStats.svcs++;
+                simCount(SIM_SVC_CYCLES);
+                svCallIsr();
+                break;
+            case SIM_EXC_SYSTICK:
+                simStats.ticks++;
+                simCount(SIM_SYSTICK_CYCLES);
+                systickIsr();
+                break;
+            case SIM_EXC_MEMFAULT:
+                simStats.faults++;
+                mpuFaultIsr();
+                break;
+            case SIM_EXC_GPIO:
+                simStats.irqs++;
+                simCount(SIM_IRQ_CYCLES);
+                simIrq(simGpioIrqPending(), pbIsr);
+                break;
+            case SIM_EXC_WTIMER0A:
+                simStats.irqs++;
+                simCount(SIM_IRQ_CYCLES);
+                microTimerIsr();
+                break;
+        }
+
+        while (simTickPending || simGpioIrqPending() || simMicroAlarmPending()
+                || (NVIC_INT_CTRL_R & NVIC_INT_CTRL_PEND_SV))
+        {
+            if (simTickPending)
+            {
+                simTickPending = false;
+                simStats.ticks++;
+                simCount(SIM_SYSTICK_CYCLES);
+                systickIsr();
+            }
+            else if (simGpioIrqPending())
+            {
+                simStats.irqs++;
+                simCount(SIM_IRQ_CYCLES);
+                simIrq(simGpioIrqPending(), pbIsr);
+            }
+            else if (simMicroAlarmPending())
+            {
+                simStats.irqs++;
+                simCount(SIM_IRQ_CYCLES);
+                microTimerIsr();
+            }
+            else
+            {
+                NVIC_INT_CTRL_R &= ~NVIC_INT_CTRL_PEND_SV;
+                simStats.switches++;
+                simCount(SIM_PENDSV_CYCLES);
+                pendSvIsr();
+            }
+        }
+
+        if (NVIC_APINT_R & NVIC_APINT_SYSRESETREQ)
+            simExit("reset requested");
+
+        simReturn();
+    }
+}
+
+// Advances simulated time, SysTick and the microsecond alarm fire here when
+// running in thread mode
+// A task preempted on the way gets the rest of its cycles once it resumes
+void simAdvance(uint32_t cycles)
+{
+    uint64_t left = cycles;
+    uint64_t alarm;
+    bool ticking;
+
+    while (true)
+    {
+        ticking = (NVIC_ST_CTRL_R & NVIC_ST_CTRL_ENABLE) && (NVIC_ST_CTRL_R & NVIC_ST_CTRL_INTEN);
+        if (!ticking)
+            simNextTick = 0;
+        else if (!simNextTick)
+            simNextTick = simCycles + NVIC_ST_RELOAD_R + 1;
+
+        // handlers tail-chain an alarm that goes off under them
+        alarm = simHandler ? 0 : simMicroAlarm();
+        if (alarm && alarm <= simCycles + left && (!ticking || alarm < simNextTick))
+        {
+            if (alarm > simCycles)
+            {
+                left -= alarm - simCycles;
+                simCount(alarm - simCycles);
+            }
+            simRaise(SIM_EXC_WTIMER0A, 0, 0, 0, 0, 0);
+            continue;
+        }
+
+        if (!ticking || simCycles + left < simNextTick)
+        {
+            simCount(left);
+            break;
+        }
+
+        left -= simNextTick - simCycles;
+        simCount(simNextTick - simCycles);
+        simNextTick += NVIC_ST_RELOAD_R + 1;
+        if (simHandler)
+            simTickPending = true;
+        else
+            simRaise(SIM_EXC_SYSTICK, 0, 0, 0, 0, 0);
+    }
+
+    // pin interrupts are taken in thread mode, handlers tail-chain them
+    if (!simHandler && simGpioIrqPending())
+        simRaise(SIM_EXC_GPIO, 0, 0, 0, 0, 0);
+
+    // stop in thread mode so a handler (fault dump, trace dump) is never cut short
+    if (simEnd && simCycles >= simEnd && !simHandler && !simExiting)
+        simExit("time limit");
+}
+
+// WFI: time jumps to the next SysTick or microsecond alarm, which is taken
+// before this returns
+void simWaitForInterrupt(void)
+{
+    uint64_t until = simNextTick;
+    uint64_t alarm = simMicroAlarm();
+
+    if (alarm && (!until || alarm < until))
+        until = alarm;
+    simAdvance(until > simCycles ? until - simCycles : 1);
+}
+
+uint32_t simSvc(uint8_t svc, uint32_t r0, uint32_t r1, uint32_t r2, uint32_t r3)
+{
+    uint32_t *frame;
+
+    simAdvance(1);
+    frame = simRaise(SIM_EXC_SVC, r0, r1, r2, r3, (uint32_t)(uintptr_t)&simSvcInsn[svc + 1]);
+    return frame[0];
+}
+
+// Pointers pass through 32-bit registers, so everything a task hands the
+// kernel must live below 4 GiB (the build is -no-pie for this reason)
+uint32_t simArg(const void *p)
+{
+    if ((uintptr_t)p >> 32)
+    {
+        fprintf(stderr, "sim: SVC argument %p does not fit in a register\n", p);
+        simExit("bad argument");
+    }
+    return (uint32_t)(uintptr_t)p;
+}
+
+static uint8_t simSlotOf(uint32_t psp)
+{
+    if (psp <= SIM_SRAM_BASE || psp > SIM_SRAM_BASE + SIM_SRAM_SIZE)
+    {
+        fprintf(stderr, "sim: PSP 0x%08X is outside of SRAM\n", psp);
+        simExit("hard fault");
+    }
+    return (psp - 1 - SIM_SRAM_BASE) / 512;
+}
+
+static void simTaskEntry(void)
+{
+    ((void (*)(void))simSlots[simCurrent].pc)();
+    fprintf(stderr, "sim: task at %p returned\n", simSlots[simCurrent].pc);
+    simExit("hard fault");
+}
+
+static void simMakeContext(uint8_t slot, void *pc)
+{
+    getcontext(&simSlots[slot].ctx);
+    simSlots[slot].ctx.uc_stack.ss_sp = simStacks[slot];
+    simSlots[slot].ctx.uc_stack.ss_size = SIM_STACK_SIZE;
+    simSlots[slot].ctx.uc_link = NULL;
+    simSlots[slot].pc = pc;
+    makecontext(&simSlots[slot].ctx, simTaskEntry, 0);
+}
+
+// runProgram: builds the first exception frame of a task on the PSP
+void simNewContext(void *pc)
+{
+    uint8_t slot = simSlotOf(simPsp);
+
+    simMakeContext(slot, pc);
+    simPushFrame(simArg(pc), 0, 0, 0, simArg(pc), slot);
+}
+
+// Handler mode, or thread mode before startRtos drops privileges
+bool simPrivileged(void)
+{
+    return simHandler;
+}
+
+// setPcTmpl: drops to unprivileged thread mode on the PSP and jumps to pc
+void simLaunch(void *pc)
+{
+    getcontext(&simKernelCtx);
+    simKernelCtx.uc_stack.ss_sp = simKernelStack;
+    simKernelCtx.uc_stack.ss_size = sizeof(simKernelStack);
+    simKernelCtx.uc_link = NULL;
+    makecontext(&simKernelCtx, simKernel, 0);
+
+    simCurrent = simSlotOf(simPsp);
+    simMakeContext(simCurrent, pc);
+
+    simHandler = false;
+    simApplyMpu(false);
+    setcontext(&simSlots[simCurrent].ctx);
+}
+
+// MPU violations by a task arrive as SIGSEGV on a protected SRAM page
+static void simSegv(int sig, siginfo_t *info, void *context)
+{
+    uintptr_t addr = (uintptr_t)info->si_addr;
+
+    if (simHandler || addr < SIM_SRAM_BASE || addr >= SIM_SRAM_BASE + SIM_SRAM_SIZE)
+    {
+        // a real crash of the simulator, let it dump core
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+
+    NVIC_MM_ADDR_R = addr;
+    NVIC_FAULT_STAT_R |= NVIC_FAULT_STAT_DERR | NVIC_FAULT_STAT_MMARV;
+    // returning re-executes the access, just like the hardware
+    simRaise(SIM_EXC_MEMFAULT, 0, 0, 0, 0, 0);
+}
+
+void simExit(const char reason[])
+{
+    FILE *trace;
+
+    if (simExiting)
+        exit(1);
+    simExiting = true;
+    simHandler = true;
+    simApplyMpu(true);
+    fflush(stdout);
+
+    if (simTraceFile)
+    {
+        trace = fopen(simTraceFile, "wb");
+        if (trace)
+        {
+            simUartSetOutput(trace);
+            traceDump();
+            fclose(trace);
+        }
+        simUartSetOutput(stdout);
+    }
+
+    fprintf(stderr, "sim: %s at %u ms (%llu cycles), %llu SVCs, %llu ticks, %llu context switches, %llu interrupts, %llu faults\n",
+            reason, simMillis(), (unsigned long long)simCycles, (unsigned long long)simStats.svcs,
+            (unsigned long long)simStats.ticks, (unsigned long long)simStats.switches,
+            (unsigned long long)simStats.irqs, (unsigned long long)simStats.faults);
+    exit(strcmp(reason, "time limit") == 0 || strcmp(reason, "exit") == 0 ? 0 : 1);
+}
+
+static void simMap(uint32_t base, uint32_t size)
+{
+    void *p = mmap((void *)(uintptr_t)base, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if (p != (void *)(uintptr_t)base)
+    {
+        fprintf(stderr, "sim: cannot map 0x%08X-0x%08X\n", base, base + size - 1);
+        exit(1);
+    }
+}
+
+// Reads whatever is waiting on stdin without blocking
+int simStdinRead(char buf[], int size)
+{
+    struct pollfd fd = {0, POLLIN, 0};
+
+    if (poll(&fd, 1, 0) <= 0)
+        return 0;
+    return read(0, buf, size);
+}
+
+static void simUsage(const char name[])
+{
+    fprintf(stderr, "usage: %s [-t ms] [-p ms:mask]... [-s ms:text]... [-i] [-l] [-T file]\n", name);
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    struct sigaction action;
+    char *arg;
+    uint16_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:p:s:ilT:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 't':
+                simEnd = strtoull(optarg, NULL, 10) * (SIM_CLOCK_HZ / 1000);
+                break;
+            case 'p':
+            case 's':
+                arg = strchr(optarg, ':');
+                if (!arg)
+                    simUsage(argv[0]);
+                if (opt == 'p')
+                    simGpioAddButtons(strtoul(optarg, NULL, 10), strtoul(arg + 1, NULL, 0));
+                else
+                    simUartAddInput(strtoul(optarg, NULL, 10), arg + 1);
+                break;
+            case 'i':
+                simUartSetInteractive(true);
+                break;
+            case 'l':
+                simGpioSetLog(true);
+                break;
+            case 'T':
+                simTraceFile = optarg;
+                break;
+            default:
+                simUsage(argv[0]);
+        }
+    }
+
+    simMap(SIM_SRAM_BASE, SIM_SRAM_SIZE);
+    simMap(SIM_SCS_BASE, SIM_SCS_SIZE);
+    for (i = 0; i < SIM_SRAM_SIZE / 0x1000; i++)
+        simPageProt[i] = PROT_READ | PROT_WRITE;
+    for (i = 0; i < 256; i++)
+        simSvcInsn[i] = 0xDF00 | i;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = simSegv;
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigaction(SIGSEGV, &action, NULL);
+
+    simUartSetOutput(stdout);
+    rtosMain();
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Host simulation core
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target:          Linux x86-64 host (simulates the TM4C123GH6PM)
+// System Clock:    40 MHz (simulated)
+
+// The unmodified kernel, memory manager, shell and task files are linked
+// against this port. SRAM (0x20000000) and the Cortex-M system control space
+// (0xE0000000 - 0xE000EFFF) are mapped at their real addresses, so register
+// accesses in kernel.c and mm.c become plain memory accesses that the core
+// below inspects. Tasks run on ucontexts, exceptions (SVC, SysTick, PendSV,
+// MemManage) run on a separate kernel context, and time only advances at
+// well defined points (SVCs, waitMicrosecond, GPIO and UART accesses), so a
+// run with the same options always produces the same output.
+
+#ifndef SIM_H_
+#define SIM_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_CLOCK_HZ        40000000
+#define SIM_CYCLES_PER_US   (SIM_CLOCK_HZ / 1000000)
+
+#define SIM_SRAM_BASE       0x20000000
+#define SIM_SRAM_SIZE       0x8000
+#define SIM_SCS_BASE        0xE0000000
+#define SIM_SCS_SIZE        0xF000
+
+// modeled costs in cycles (entry + exit of each exception, peripheral access)
+#define SIM_SVC_CYCLES      40
+#define SIM_SYSTICK_CYCLES  40
+#define SIM_PENDSV_CYCLES   80
+#define SIM_IRQ_CYCLES      40
+#define SIM_GPIO_CYCLES     4
+#define SIM_UART_CYCLES     4
+
+// exceptions the core can raise
+#define SIM_EXC_SVC         11
+#define SIM_EXC_SYSTICK     15
+#define SIM_EXC_MEMFAULT    4
+#define SIM_EXC_GPIO        16  // any GPIO port, dispatched to pbIsr
+#define SIM_EXC_WTIMER0A    110 // microsecond alarm, dispatched to microTimerIsr
+
+typedef struct _SIM_STATS
+{
+    uint64_t svcs;
+    uint64_t ticks;
+    uint64_t switches;
+    uint64_t irqs;
+    uint64_t faults;
+} SIM_STATS;
+
+extern uint64_t simCycles;
+extern uint32_t simPsp;
+extern SIM_STATS simStats;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// time
+void simAdvance(uint32_t cycles);
+void simWaitForInterrupt(void);
+uint32_t simMillis(void);
+
+// exceptions and task contexts (used by spctl.c and svc.c)
+uint32_t simSvc(uint8_t svc, uint32_t r0, uint32_t r1, uint32_t r2, uint32_t r3);
+uint32_t simArg(const void *p);
+void simLaunch(void *pc);
+void simNewContext(void *pc);
+void simExit(const char reason[]);
+bool simPrivileged(void);
+int simStdinRead(char buf[], int size);
+
+// peripherals (uart0.c, gpio.c and board.c)
+void simUartAddInput(uint32_t ms, const char text[]);
+void simUartSetInteractive(bool on);
+void simUartSetOutput(FILE *file);
+void simGpioAddButtons(uint32_t ms, uint8_t mask);
+void simGpioSetLog(bool on);
+uint8_t simGpioIrqPending(void);
+uint64_t simMicroAlarm(void);
+bool simMicroAlarmPending(void);
+
+#endif
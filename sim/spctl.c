@@ -0,0 +1,118 @@
+// Stack pointer control functions for the host simulation
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target:          Linux x86-64 host (simulates the TM4C123GH6PM)
+// System Clock:    40 MHz (simulated)
+
+// Same interface as spctl.s. The PSP is a plain variable that moves through
+// the task's SRAM stack exactly like the real one (exception frames of 32 B,
+// R4-R11 and LR saved as 36 B), while the task's C code runs on a host stack.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "spctl.h"
+#include "sim.h"
+
+#define SAVED_REGS          9           // R4-R11, LR
+#define EXC_RETURN_PSP      0xFFFFFFFD
+
+static uint32_t mspStack[64];
+static uint32_t primask = 0;
+static uint32_t basepri = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void usePsp(void)
+{
+}
+
+void setPsp(uint32_t psp)
+{
+    // the two low bits of the PSP always read as zero
+    simPsp = psp & ~3;
+}
+
+uint32_t *getPsp(void)
+{
+    return (uint32_t *)(uintptr_t)simPsp;
+}
+
+uint32_t *getMsp(void)
+{
+    return &mspStack[64];
+}
+
+void *setMsp(uint32_t msp)
+{
+    return 0;
+}
+
+void setPcTmpl(void *pc)
+{
+    simLaunch(pc);
+}
+
+void strRegs(void)
+{
+    uint8_t i;
+
+    simPsp -= SAVED_REGS * 4;
+    for (i = 0; i < SAVED_REGS - 1; i++)
+        getPsp()[i] = 0;
+    getPsp()[SAVED_REGS - 1] = EXC_RETURN_PSP;
+}
+
+void ldrRegs(void)
+{
+    simPsp += SAVED_REGS * 4;
+}
+
+void runProgram(void *pc)
+{
+    simNewContext(pc);
+}
+
+bool isPrivileged(void)
+{
+    return simPrivileged();
+}
+
+void strPid(uint32_t pid)
+{
+    *getPsp() = pid;
+}
+
+uint32_t enterCritical(void)
+{
+    uint32_t old = primask;
+    primask = 1;
+    return old;
+}
+
+void leaveCritical(uint32_t old)
+{
+    primask = old;
+}
+
+// nothing preempts a handler here, the value is only kept for the caller
+uint32_t setBasepri(uint32_t value)
+{
+    uint32_t old = basepri;
+    basepri = value;
+    return old;
+}
+
+void waitForInterrupt(void)
+{
+    simWaitForInterrupt();
+}
@@ -0,0 +1,43 @@
+// SVC stubs for the host simulation
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target:          Linux x86-64 host (simulates the TM4C123GH6PM)
+// System Clock:    40 MHz (simulated)
+
+// These replace the target's SVC stubs (../svc.c) and are generated from the
+// same list (syscalls.h). On the target the arguments are
+// already in R0-R3 when "SVC #n" runs, here they are stacked explicitly, and
+// svCallIsr() decodes the same frame.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "kernel.h"
+#include "shell.h"
+#include "sim.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// each stub stacks its arguments and returns the stacked R0 the handler left
+#define ARG(kind, size, param) simArg((const void *)(uintptr_t)(param))
+#define NO_ARG 0
+#define SYSCALL(n, type, name, params, a0, a1, a2, a3)     \
+    type name params                                       \
+    {                                                      \
+        return (type)(uintptr_t)simSvc(n, a0, a1, a2, a3); \
+    }
+#define SYSCALL_VOID(n, name, params, a0, a1, a2, a3)      \
+    void name params                                       \
+    {                                                      \
+        simSvc(n, a0, a1, a2, a3);                         \
+    }
+#include "syscalls.h"
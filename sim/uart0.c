@@ -0,0 +1,163 @@
+// UART0 Library for the host simulation
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target:          Linux x86-64 host (simulates the TM4C123GH6PM)
+// System Clock:    40 MHz (simulated)
+
+// TX goes to stdout, paced like a 16-deep FIFO at the programmed baud rate.
+// RX comes from the -s ms:text script (and stdin with -i).
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "kernel.h"
+#include "uart0.h"
+#include "sim.h"
+
+#define FIFO_DEPTH  16
+#define MAX_INPUTS  64
+#define BITS_PER_CHAR 10
+
+typedef struct _SIM_INPUT
+{
+    uint32_t ms;
+    char *text;
+} SIM_INPUT;
+
+static SIM_INPUT inputs[MAX_INPUTS];
+static uint8_t inputCount = 0;
+static uint8_t inputIndex = 0;
+static uint16_t inputPos = 0;
+static bool interactive = false;
+static char stdinBuf[64];
+static uint8_t stdinCount = 0;
+static uint8_t stdinPos = 0;
+
+static FILE *out;
+static uint32_t baud = 115200;
+static uint64_t txDone = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Queues a line to be typed at ms, kept in time order
+void simUartAddInput(uint32_t ms, const char text[])
+{
+    uint8_t i;
+
+    if (inputCount == MAX_INPUTS)
+        return;
+
+    i = inputCount++;
+    while (i && inputs[i - 1].ms > ms)
+    {
+        inputs[i] = inputs[i - 1];
+        i--;
+    }
+    inputs[i].ms = ms;
+    inputs[i].text = malloc(strlen(text) + 2);
+    strcpy(inputs[i].text, text);
+    strcat(inputs[i].text, "\r");
+}
+
+void simUartSetInteractive(bool on)
+{
+    interactive = on;
+}
+
+void simUartSetOutput(FILE *file)
+{
+    out = file;
+}
+
+static bool stdinReady(void)
+{
+    int len;
+    uint8_t i;
+
+    if (stdinPos < stdinCount)
+        return true;
+    if (!interactive)
+        return false;
+
+    len = simStdinRead(stdinBuf, sizeof(stdinBuf));
+    if (len <= 0)
+        return false;
+    for (i = 0; i < len; i++)
+        if (stdinBuf[i] == '\n')
+            stdinBuf[i] = '\r';
+    stdinCount = len;
+    stdinPos = 0;
+    return true;
+}
+
+void initUart0()
+{
+}
+
+void setUart0BaudRate(uint32_t baudRate, uint32_t fcyc)
+{
+    baud = baudRate;
+}
+
+// Blocks (in simulated time) while the TX FIFO is full
+void putcUart0(char c)
+{
+    uint32_t charCycles = SIM_CLOCK_HZ / baud * BITS_PER_CHAR;
+
+    if (txDone < simCycles)
+        txDone = simCycles;
+    if (txDone - simCycles > FIFO_DEPTH * charCycles)
+        simAdvance(txDone - simCycles - FIFO_DEPTH * charCycles);
+    else
+        simAdvance(SIM_UART_CYCLES);
+    txDone += charCycles;
+
+    fputc(c, out);
+}
+
+void putsUart0(char* str)
+{
+    uint8_t i = 0;
+    while (str[i] != '\0')
+        putcUart0(str[i++]);
+}
+
+char getcUart0()
+{
+    char c;
+
+    while (!kbhitUart0())
+    {
+        yield();
+    }
+
+    if (inputIndex < inputCount && inputs[inputIndex].ms <= simMillis())
+    {
+        c = inputs[inputIndex].text[inputPos++];
+        if (inputs[inputIndex].text[inputPos] == '\0')
+        {
+            inputIndex++;
+            inputPos = 0;
+        }
+        return c;
+    }
+    return stdinBuf[stdinPos++];
+}
+
+bool kbhitUart0()
+{
+    simAdvance(SIM_UART_CYCLES);
+    return (inputIndex < inputCount && inputs[inputIndex].ms <= simMillis()) || stdinReady();
+}
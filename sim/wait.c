@@ -0,0 +1,27 @@
+// Wait functions for the host simulation
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target:          Linux x86-64 host (simulates the TM4C123GH6PM)
+// System Clock:    40 MHz (simulated)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include "wait.h"
+#include "sim.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Busy waiting only moves simulated time, SysTick still preempts it
+void waitMicrosecond(uint32_t us)
+{
+    simAdvance(us * SIM_CYCLES_PER_US);
+}
@@ -2,6 +2,7 @@
 #define SPCTL_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <kernel.h>
 
 void usePsp(void);
@@ -14,5 +15,10 @@ void strRegs(void);
 void ldrRegs(void);
 void runProgram(void *pc);
 void strPid(uint32_t pid);
+uint32_t enterCritical(void);
+void leaveCritical(uint32_t primask);
+uint32_t setBasepri(uint32_t basepri);
+void waitForInterrupt(void);
+bool isPrivileged(void);
 
 #endif
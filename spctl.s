@@ -11,6 +11,11 @@
 	.def ldrRegs
 	.def runProgram
 	.def strPid
+	.def enterCritical
+	.def leaveCritical
+	.def setBasepri
+	.def waitForInterrupt
+	.def isPrivileged
 
 .thumb
 .const
@@ -99,4 +104,35 @@ strPid:
 	ISB
 	BX LR
 
+enterCritical:
+	MRS R0, PRIMASK		; return the old PRIMASK so calls can nest
+	CPSID I				; mask all configurable interrupts
+	BX LR
+
+leaveCritical:
+	MSR PRIMASK, R0		; restore the PRIMASK from enterCritical
+	BX LR
+
+setBasepri:
+	MRS R1, BASEPRI		; return the old BASEPRI so calls can nest
+	MSR BASEPRI, R0		; mask interrupts at this priority and below
+	ISB
+	MOV R0, R1
+	BX LR
+
+waitForInterrupt:
+	WFI					; sleep until an interrupt is pending, allowed unprivileged
+	BX LR
+
+isPrivileged:
+	MRS R0, IPSR		; handler mode is always privileged
+	CBNZ R0, privileged
+	MRS R0, CONTROL		; thread mode is unless TMPL/nPRIV (2^0) is set
+	AND R0, R0, #1
+	EOR R0, R0, #1
+	BX LR
+privileged:
+	MOV R0, #1
+	BX LR
+
 .endm
@@ -0,0 +1,42 @@
+// SVC stubs
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// One stub per line of syscalls.h. The arguments are in R0-R3 when "SVC #n"
+// runs and svCallIsr leaves the result in R0, so a stub has no return
+// statement and only works as a real call. They live apart from kernel.c,
+// which calls several of them, so that the compiler cannot inline one and
+// lose the registers. The host simulation supplies its own (sim/svc.c).
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "kernel.h"
+#include "shell.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+#define ARG(kind, size, param)
+#define NO_ARG
+#define SYSCALL(n, type, name, params, a0, a1, a2, a3) \
+    type name params                                  \
+    {                                                 \
+        __asm("    SVC #" #n);                        \
+    }
+#define SYSCALL_VOID(n, name, params, a0, a1, a2, a3) SYSCALL(n, void, name, params, a0, a1, a2, a3)
+#include "syscalls.h"
+#undef SYSCALL_VOID
+#undef SYSCALL
+#undef NO_ARG
+#undef ARG
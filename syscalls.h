@@ -0,0 +1,150 @@
+// Kernel call table
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// One line per SVC, with no include guard: svc.c includes it to generate the
+// "SVC #n" stubs, kernel.c the dispatch table of svCallIsr(), sim/svc.c the
+// host stubs. The includer defines
+//   SYSCALL(n, type, name, (params), arg0, arg1, arg2, arg3)
+//   SYSCALL_VOID(n, name, (params), arg0, arg1, arg2, arg3)
+//   ARG(kind, size, param) and NO_ARG
+// The arguments are R0-R3 in order, svCallIsr checks each one by its kind
+// before it calls the handler (name##Svc in kernel.c):
+//   VALUE           anything
+//   BOOL            0 or 1
+//   MUTEX, SEMAPHORE, GROUP, QUEUE, COND, RW, TIMER, POOL
+//                   an object of that pool in use
+//   PRIORITY        below NUM_PRIORITIES
+//   THREAD          handle of a thread that still exists
+//   STRING          zero terminated within size bytes the task can read
+//   IN, OUT         size bytes the task can read (flash too) or write
+//   MSG_IN, MSG_OUT one message of the queue in argument 0, read or written
+// A call that fails a check returns 0 without running the handler.
+
+// Threads
+SYSCALL_VOID(1, yield, (void), NO_ARG, NO_ARG, NO_ARG, NO_ARG)
+// Blocks for tick ms
+SYSCALL_VOID(2, sleep, (uint32_t tick), ARG(VALUE, 0, tick), NO_ARG, NO_ARG, NO_ARG)
+// Returns the handle of the thread called name, NO_THREAD if there is none
+SYSCALL(7, _thread, getPid, (const char name[]), ARG(STRING, sizeof(tcb[0].name), name), NO_ARG, NO_ARG, NO_ARG)
+// Starts a thread over from its function on an empty stack, after
+// releasing what stopThread does and the message blocks it owns
+SYSCALL_VOID(8, restartThread, (_thread thread), ARG(THREAD, 0, thread), NO_ARG, NO_ARG, NO_ARG)
+// Also removes the thread from the wait list it is on and hands over the
+// mutexes and rw locks it holds, the idle task cannot be stopped
+SYSCALL_VOID(10, stopThread, (_thread thread), ARG(THREAD, 0, thread), NO_ARG, NO_ARG, NO_ARG)
+SYSCALL_VOID(12, setThreadPriority, (_thread thread, uint8_t priority), ARG(THREAD, 0, thread), ARG(PRIORITY, 0, priority), NO_ARG, NO_ARG)
+// createThread for running tasks, which call createThread and end up here
+SYSCALL(43, _thread, spawnThread, (_fn fn, const char name[], uint8_t priority, uint32_t stackBytes), ARG(IN, 1, fn), ARG(STRING, sizeof(tcb[0].name), name), ARG(PRIORITY, 0, priority), ARG(VALUE, 0, stackBytes))
+// Ends a thread for good: what stopThread releases, the message blocks it
+// owns and its stack, and its handle stops working
+// Returns false for the idle task
+SYSCALL(44, bool, destroyThread, (_thread thread), ARG(THREAD, 0, thread), NO_ARG, NO_ARG, NO_ARG)
+// Blocks for us microseconds (up to INT32_MAX), woken by the compare
+// interrupt of the microsecond timer instead of the 1 ms SysTick
+SYSCALL_VOID(41, usleep, (uint32_t us), ARG(VALUE, 0, us), NO_ARG, NO_ARG, NO_ARG)
+
+// Shell
+SYSCALL_VOID(9, preempt, (bool on), ARG(BOOL, 0, on), NO_ARG, NO_ARG, NO_ARG)
+SYSCALL_VOID(11, reboot, (void), NO_ARG, NO_ARG, NO_ARG, NO_ARG)
+SYSCALL_VOID(13, getMutexInfo, (IPCS_MUT_DATA *mutex_data, uint8_t mutex), ARG(OUT, sizeof(IPCS_MUT_DATA), mutex_data), ARG(MUTEX, 0, mutex), NO_ARG, NO_ARG)
+SYSCALL_VOID(14, getSemaphoreInfo, (IPCS_SEM_DATA *sem_data, uint8_t semaphore), ARG(OUT, sizeof(IPCS_SEM_DATA), sem_data), ARG(SEMAPHORE, 0, semaphore), NO_ARG, NO_ARG)
+SYSCALL_VOID(15, sched, (bool prio_on), ARG(BOOL, 0, prio_on), NO_ARG, NO_ARG, NO_ARG)
+SYSCALL_VOID(16, getTcb, (PS_DATA *ps_data), ARG(OUT, sizeof(PS_DATA), ps_data), NO_ARG, NO_ARG, NO_ARG)
+// Copies the trace ring and task names for the shell to write out with
+// traceWrite, so the kernel does not wait for the UART
+SYSCALL_VOID(17, copyTrace, (TRACE_DATA *trace), ARG(OUT, sizeof(TRACE_DATA), trace), NO_ARG, NO_ARG, NO_ARG)
+// Copies the state and contention counters of a rw lock for ipcs
+SYSCALL(36, bool, getRwLockInfo, (IPCS_RW_DATA *rw_data, uint8_t rw), ARG(OUT, sizeof(IPCS_RW_DATA), rw_data), ARG(RW, 0, rw), NO_ARG, NO_ARG)
+SYSCALL_VOID(37, pi, (bool on), ARG(BOOL, 0, on), NO_ARG, NO_ARG, NO_ARG)
+
+// Mutexes and semaphores
+SYSCALL_VOID(3, lock, (uint8_t mutex), ARG(MUTEX, 0, mutex), NO_ARG, NO_ARG, NO_ARG)
+SYSCALL_VOID(4, unlock, (uint8_t mutex), ARG(MUTEX, 0, mutex), NO_ARG, NO_ARG, NO_ARG)
+SYSCALL_VOID(5, wait, (uint8_t semaphore), ARG(SEMAPHORE, 0, semaphore), NO_ARG, NO_ARG, NO_ARG)
+SYSCALL_VOID(6, post, (uint8_t semaphore), ARG(SEMAPHORE, 0, semaphore), NO_ARG, NO_ARG, NO_ARG)
+// Waits at most ticks ms for a semaphore, returns false on timeout
+// (ticks = 0 never blocks)
+SYSCALL(18, bool, waitTimeout, (uint8_t semaphore, uint32_t ticks), ARG(SEMAPHORE, 0, semaphore), ARG(VALUE, 0, ticks), NO_ARG, NO_ARG)
+// Locks a mutex, waiting at most ticks ms, returns false on timeout
+// (ticks = 0 never blocks)
+SYSCALL(19, bool, lockTimeout, (uint8_t mutex, uint32_t ticks), ARG(MUTEX, 0, mutex), ARG(VALUE, 0, ticks), NO_ARG, NO_ARG)
+
+// Event groups
+// Sets flags in an event group, waking every waiter they satisfy
+SYSCALL_VOID(20, setFlags, (uint8_t group, uint32_t flags), ARG(GROUP, 0, group), ARG(VALUE, 0, flags), NO_ARG, NO_ARG)
+// Clears flags in an event group, returns the flags before clearing
+SYSCALL(21, uint32_t, clearFlags, (uint8_t group, uint32_t flags), ARG(GROUP, 0, group), ARG(VALUE, 0, flags), NO_ARG, NO_ARG)
+// Waits at most ticks ms for any (or with FLAGS_ALL every) flag in mask,
+// FLAGS_CLEAR clears the mask on the way out
+// Returns the flags in mask that were set, 0 on timeout
+// (ticks = 0 never blocks, WAIT_FOREVER never times out)
+SYSCALL(22, uint32_t, waitFlags, (uint8_t group, uint32_t mask, uint8_t mode, uint32_t ticks), ARG(GROUP, 0, group), ARG(VALUE, 0, mask), ARG(VALUE, 0, mode), ARG(VALUE, 0, ticks))
+
+// Queues and message blocks
+// Copies a message into a queue, waiting at most ticks ms for room
+// Returns false on timeout (ticks = 0 never blocks, WAIT_FOREVER never
+// times out), on a block queue msg points to the block pointer and the
+// block moves to the receiver
+SYSCALL(23, bool, sendMessage, (uint8_t queue, const void *msg, uint32_t ticks), ARG(QUEUE, 0, queue), ARG(MSG_IN, 0, msg), ARG(VALUE, 0, ticks), NO_ARG)
+// Like sendMessage, but the message goes ahead of every queued one
+SYSCALL(24, bool, sendUrgentMessage, (uint8_t queue, const void *msg, uint32_t ticks), ARG(QUEUE, 0, queue), ARG(MSG_IN, 0, msg), ARG(VALUE, 0, ticks), NO_ARG)
+// Copies the oldest message of a queue into msg, waiting at most ticks ms
+// Returns false on timeout
+SYSCALL(25, bool, receiveMessage, (uint8_t queue, void *msg, uint32_t ticks), ARG(QUEUE, 0, queue), ARG(MSG_OUT, 0, msg), ARG(VALUE, 0, ticks), NO_ARG)
+// Takes a free message block, which only the calling task can access
+// Returns 0 if every block is in use
+SYSCALL(26, void *, allocBlock, (void), NO_ARG, NO_ARG, NO_ARG, NO_ARG)
+// Returns a message block of the calling task to the pool, a task it was
+// shared with loses access too
+SYSCALL(27, bool, freeBlock, (void *block), ARG(VALUE, 0, block), NO_ARG, NO_ARG, NO_ARG)
+// Gives thread access to a message block of the calling task as well, for
+// memory both need (eg. a ring) rather than messages
+// A shared block cannot be sent, only freed
+SYSCALL(28, bool, shareBlock, (void *block, _thread thread), ARG(VALUE, 0, block), ARG(THREAD, 0, thread), NO_ARG, NO_ARG)
+
+// Condition variables
+// Unlocks mutex and waits for a signal in one step, returns once the task
+// holds mutex again (recheck the condition, another task may have run first)
+// Returns false at once if the calling task does not hold mutex
+SYSCALL(29, bool, condWait, (uint8_t cv, uint8_t mutex), ARG(COND, 0, cv), ARG(MUTEX, 0, mutex), NO_ARG, NO_ARG)
+// Wakes the first task waiting on a condition variable, if any
+SYSCALL_VOID(30, condSignal, (uint8_t cv), ARG(COND, 0, cv), NO_ARG, NO_ARG, NO_ARG)
+// Wakes every task waiting on a condition variable, they get the mutex
+// one after the other
+SYSCALL_VOID(31, condBroadcast, (uint8_t cv), ARG(COND, 0, cv), NO_ARG, NO_ARG, NO_ARG)
+
+// Readers-writer locks are not recursive, a lock by a task that already
+// holds the rw lock is ignored
+// Locks a rw lock for reading, together with other readers
+// Waits while a writer holds it or waits for it
+SYSCALL_VOID(32, readLock, (uint8_t rw), ARG(RW, 0, rw), NO_ARG, NO_ARG, NO_ARG)
+SYSCALL_VOID(33, readUnlock, (uint8_t rw), ARG(RW, 0, rw), NO_ARG, NO_ARG, NO_ARG)
+// Locks a rw lock for writing, waiting until the readers are done
+SYSCALL_VOID(34, writeLock, (uint8_t rw), ARG(RW, 0, rw), NO_ARG, NO_ARG, NO_ARG)
+SYSCALL_VOID(35, writeUnlock, (uint8_t rw), ARG(RW, 0, rw), NO_ARG, NO_ARG, NO_ARG)
+
+// Timers and the work and idle tasks
+// Waits for the next work item, for the work task
+SYSCALL_VOID(38, getWork, (void *item), ARG(OUT, sizeof(workItem), item), NO_ARG, NO_ARG, NO_ARG)
+// Starts (or restarts) a timer that runs out in ticks ms, and again every
+// ticks ms after that with autoReload
+// Returns false for a timer not in use or ticks = 0
+SYSCALL(39, bool, startTimer, (uint8_t timer, uint32_t ticks, bool autoReload), ARG(TIMER, 0, timer), ARG(VALUE, 0, ticks), ARG(BOOL, 0, autoReload), NO_ARG)
+// Stops a timer, returns false if it was not running
+SYSCALL(40, bool, stopTimer, (uint8_t timer), ARG(TIMER, 0, timer), NO_ARG, NO_ARG, NO_ARG)
+// Returns the hook set by setIdleHook, for the idle task
+SYSCALL(42, _fn, getIdleHook, (void), NO_ARG, NO_ARG, NO_ARG, NO_ARG)
+
+// Worker pools
+// Queues fn(arg) for a worker of pool, never blocks
+// Returns false if every deque of the pool is full
+SYSCALL(45, bool, submitJob, (uint8_t pool, _workFn fn, uint32_t arg), ARG(POOL, 0, pool), ARG(IN, 1, fn), ARG(VALUE, 0, arg), NO_ARG)
+// Takes the next job for a pool worker, or waits for one and returns false
+SYSCALL(46, bool, getJob, (void *job), ARG(OUT, sizeof(workItem), job), NO_ARG, NO_ARG, NO_ARG)
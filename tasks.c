@@ -26,6 +26,7 @@
 #define PB3 PORTA,3
 #define PB4 PORTA,2
 #define PB5 PORTF,4
+#define PB_MASK 0x3F
 
 #define R_LED PORTF,1
 
@@ -39,6 +40,16 @@
 // Subroutines
 //-----------------------------------------------------------------------------
 
+void clearPbInterrupts(void)
+{
+    clearPinInterrupt(PB0);
+    clearPinInterrupt(PB1);
+    clearPinInterrupt(PB2);
+    clearPinInterrupt(PB3);
+    clearPinInterrupt(PB4);
+    clearPinInterrupt(PB5);
+}
+
 // Initialize Hardware
 // REQUIRED: Add initialization for blue, orange, red, green, and yellow LEDs
 //           Add initialization for 6 pushbuttons
@@ -76,6 +87,28 @@ void initHw(void)
     enablePinPullup(PB3);
     enablePinPullup(PB4);
     enablePinPullup(PB5);
+
+    // pushbutton presses interrupt (pbIsr) through GPIO ports A, B, E and F
+    selectPinInterruptFallingEdge(PB0);
+    selectPinInterruptFallingEdge(PB1);
+    selectPinInterruptFallingEdge(PB2);
+    selectPinInterruptFallingEdge(PB3);
+    selectPinInterruptFallingEdge(PB4);
+    selectPinInterruptFallingEdge(PB5);
+    clearPbInterrupts();
+    enablePinInterrupt(PB0);
+    enablePinInterrupt(PB1);
+    enablePinInterrupt(PB2);
+    enablePinInterrupt(PB3);
+    enablePinInterrupt(PB4);
+    enablePinInterrupt(PB5);
+    // pbIsr calls the kernel, so it runs at the kernel's priority
+    ((volatile uint8_t *)&NVIC_PRI0_R)[INT_GPIOA - 16] = KERNEL_PRIORITY;
+    ((volatile uint8_t *)&NVIC_PRI0_R)[INT_GPIOB - 16] = KERNEL_PRIORITY;
+    ((volatile uint8_t *)&NVIC_PRI0_R)[INT_GPIOE - 16] = KERNEL_PRIORITY;
+    ((volatile uint8_t *)&NVIC_PRI0_R)[INT_GPIOF - 16] = KERNEL_PRIORITY;
+    NVIC_EN0_R = (1 << (INT_GPIOA - 16)) | (1 << (INT_GPIOB - 16))
+               | (1 << (INT_GPIOE - 16)) | (1 << (INT_GPIOF - 16));
 }
 
 // REQUIRED: add code to return a value from 0-63 indicating which of 6 PBs are pressed
@@ -104,17 +137,21 @@ uint8_t readPbs(void)
     return sum;
 }
 
-// one task must be ready at all times or the scheduler will fail
-// the idle task is implemented for this purpose
-void idle(void)
+// Pushbutton press interrupt (GPIO ports A, B, E and F)
+// Hands the pressed buttons to readKeys through keyEvents
+void pbIsr(void)
 {
-    while(true)
-    {
-        setPinValue(ORANGE_LED, 1);
-        waitMicrosecond(1000);
-        setPinValue(ORANGE_LED, 0);
-        yield();
-    }
+    TRACE_ISR_BEGIN();
+    clearPbInterrupts();
+    setFlagsFromIsr(keyEvents, readPbs());
+    TRACE_ISR_END();
+}
+
+// Idle hook, called by the kernel's idle task each time before it sleeps
+// The orange LED flickers while the cpu has time to spare
+void idleLed(void)
+{
+    togglePinValue(ORANGE_LED);
 }
 
 void idle2(void)
@@ -173,16 +210,15 @@ void lengthyFn(void)
 
 void readKeys(void)
 {
+    _thread flash = getPid("Flash4Hz");
+    _thread lengthy = getPid("LengthyFn");
     uint8_t buttons;
     while(true)
     {
         wait(keyReleased);
-        buttons = 0;
-        while (buttons == 0)
-        {
-            buttons = readPbs();
-            yield();
-        }
+        // presses seen while the last one was being debounced are stale
+        clearFlags(keyEvents, PB_MASK);
+        buttons = waitFlags(keyEvents, PB_MASK, FLAGS_ANY | FLAGS_CLEAR, WAIT_FOREVER);
         post(keyPressed);
         if ((buttons & 1) != 0)
         {
@@ -196,15 +232,15 @@ void readKeys(void)
         }
         if ((buttons & 4) != 0)
         {
-            restartThread(flash4Hz);
+            restartThread(flash);
         }
         if ((buttons & 8) != 0)
         {
-            stopThread(flash4Hz);
+            stopThread(flash);
         }
         if ((buttons & 16) != 0)
         {
-            setThreadPriority(lengthyFn, 4);
+            setThreadPriority(lengthy, 4);
         }
         yield();
     }
@@ -16,8 +16,10 @@
 //-----------------------------------------------------------------------------
 
 void initHw(void);
+void clearPbInterrupts(void);
+void pbIsr(void);
 
-void idle(void);
+void idleLed(void);
 void idle2(void);
 void flash4Hz(void);
 void oneshot(void);
@@ -40,6 +40,10 @@ SECTIONS
     .bss    :   > SRAM
     .sysmem :   > SRAM
     .stack  :   > SRAM
+
+    /* LOG() format strings, kept in the .out for tools/logtok.py but never */
+    /* loaded to the device. The address must match LOG_TOKEN_BASE in log.h */
+    .logstr :   type = COPY, load = 0x80000000
 }
 
 __STACK_TOP = __stack + 512;
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+# Kernel benchmark result collector and comparator
+# Rolando Rosales
+#
+# Reads the "bench,board,test,avg,min,max,ops" records that bench.c prints
+# (anything else in the capture is ignored). With one capture it writes the
+# results as CSV or JSON, with two it compares the averages test by test.
+#
+# Usage:
+#   benchcmp.py capture.txt                      CSV on stdout
+#   benchcmp.py capture.txt --json -o base.json
+#   benchcmp.py base.txt new.txt --fail 10       exit 1 if any test is >10% slower
+
+import argparse
+import json
+import sys
+
+FIELDS = ('avg', 'min', 'max', 'ops')
+
+
+def load(path):
+    results = {}
+    board = None
+    with open(path, 'rb') as f:
+        for line in f.read().decode('latin-1').splitlines():
+            parts = line.strip().split(',')
+            if len(parts) != 7 or parts[0] != 'bench':
+                continue
+            try:
+                values = [int(v) for v in parts[3:]]
+            except ValueError:
+                continue
+            board = parts[1]
+            results[parts[2]] = dict(zip(FIELDS, values))
+    if not results:
+        sys.exit('%s: no bench records found' % path)
+    return board, results
+
+
+def write(board, results, out, as_json):
+    if as_json:
+        json.dump({'board': board, 'results': results}, out, indent=2)
+        out.write('\n')
+        return
+    out.write('board,test,%s\n' % ','.join(FIELDS))
+    for test, r in results.items():
+        out.write('%s,%s,%s\n' % (board, test, ','.join(str(r[k]) for k in FIELDS)))
+
+
+def compare(base, new, fail):
+    (base_board, base), (new_board, new) = base, new
+    if base_board != new_board:
+        sys.stderr.write('warning: comparing %s against %s\n' % (base_board, new_board))
+    worst = 0.0
+    print('%-18s %10s %10s %8s' % ('test', 'base', 'new', 'change'))
+    for test in list(base) + [t for t in new if t not in base]:
+        if test not in base or test not in new:
+            print('%-18s %10s %10s %8s' % (test, base.get(test, {}).get('avg', '-'),
+                                           new.get(test, {}).get('avg', '-'), ''))
+            continue
+        a, b = base[test]['avg'], new[test]['avg']
+        change = (b - a) * 100.0 / a if a else 0.0
+        worst = max(worst, change)
+        print('%-18s %10d %10d %+7.1f%%' % (test, a, b, change))
+    if fail is not None and worst > fail:
+        sys.exit('slowest change %+.1f%% is above %.1f%%' % (worst, fail))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Collect and compare kernel benchmark results')
+    parser.add_argument('captures', nargs='+', help='one capture to convert, two to compare')
+    parser.add_argument('-o', '--output')
+    parser.add_argument('--json', action='store_true', help='write JSON instead of CSV')
+    parser.add_argument('--fail', type=float, help='percent slowdown that fails the comparison')
+    args = parser.parse_args()
+
+    if len(args.captures) == 1:
+        out = open(args.output, 'w') if args.output else sys.stdout
+        write(*load(args.captures[0]), out=out, as_json=args.json)
+        if out is not sys.stdout:
+            out.close()
+    elif len(args.captures) == 2:
+        compare(load(args.captures[0]), load(args.captures[1]), args.fail)
+    else:
+        parser.error('expected one or two captures')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+# Tokenized log string table extractor and decoder
+# Rolando Rosales
+#
+# extract: reads the .logstr section out of the linked .out (ELF) file and
+#          writes a token table (token,format) as CSV
+# decode:  reads a captured UART byte stream, passes shell text through and
+#          expands every LOG() frame back into text
+#
+# Frame format (see log.c):
+#   0x00, length, varint token, varint arg0, ... varint argN
+#
+# Binary trace dumps (trace.h, the shell's trace command and the fault
+# handlers) in the stream are skipped, tools/trace2json.py converts them
+#
+# Usage:
+#   logtok.py extract Debug/4354_RTOS.out -o logtokens.csv
+#   logtok.py decode logtokens.csv capture.bin
+#   logtok.py decode logtokens.csv --port /dev/ttyACM0
+
+import argparse
+import csv
+import re
+import struct
+import sys
+
+SECTION = '.logstr'
+FRAME_START = 0x00
+CONVERSION = re.compile(r'%(0?\d*)([udxXc%])')
+TRACE_MAGIC = b'\x01TRC'
+
+
+def read_section(path, name):
+    with open(path, 'rb') as f:
+        elf = f.read()
+    if elf[:4] != b'\x7fELF':
+        sys.exit('%s: not an ELF file' % path)
+    is64 = elf[4] == 2
+    endian = '<' if elf[5] == 1 else '>'
+    if is64:
+        shoff, = struct.unpack_from(endian + 'Q', elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', elf, 0x3A)
+        header = endian + 'IIQQQQIIQQ'
+    else:
+        shoff, = struct.unpack_from(endian + 'I', elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', elf, 0x2E)
+        header = endian + 'IIIIIIIIII'
+    sections = [struct.unpack_from(header, elf, shoff + i * shentsize) for i in range(shnum)]
+    names = sections[shstrndx]
+    for sh in sections:
+        start = names[4] + sh[0]
+        section_name = elf[start:elf.index(b'\0', start)].decode()
+        if section_name == name:
+            return sh[3], elf[sh[4]:sh[4] + sh[5]]
+    sys.exit('%s: no %s section, was the image built with LOG_TOKENIZED?' % (path, name))
+
+
+def extract(args):
+    base, data = read_section(args.elf, SECTION)
+    out = open(args.output, 'w', newline='') if args.output else sys.stdout
+    writer = csv.writer(out)
+    offset = 0
+    while offset < len(data):
+        end = data.index(b'\0', offset)
+        if end > offset:
+            # tokens are offsets from LOG_TOKEN_BASE, the section load address
+            writer.writerow([offset, data[offset:end].decode('latin-1')])
+        offset = end + 1
+    if out is not sys.stdout:
+        out.close()
+
+
+def load_table(path):
+    with open(path, newline='') as f:
+        return {int(token): fmt for token, fmt in csv.reader(f)}
+
+
+def varints(payload):
+    value = shift = 0
+    for byte in payload:
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            yield value & 0xFFFFFFFF
+            value = shift = 0
+    if shift:
+        raise ValueError('truncated varint')
+
+
+def expand(fmt, values):
+    values = list(values)
+    specs = [m for m in CONVERSION.finditer(fmt) if m.group(2) != '%']
+    if len(specs) != len(values):
+        raise ValueError('expected %d args, got %d' % (len(specs), len(values)))
+    converted = []
+    for spec, value in zip(specs, values):
+        if spec.group(2) == 'd' and value & 0x80000000:
+            value -= 1 << 32
+        elif spec.group(2) == 'c':
+            value = chr(value & 0xFF)
+        converted.append(value)
+    return fmt % tuple(converted)
+
+
+# length of the trace dump at the start of pending, 0 if there is none there
+# and None if more bytes are needed to tell
+def trace_dump(pending):
+    if not pending.startswith(TRACE_MAGIC[:len(pending)]):
+        return 0
+    # magic, version, task count, record count, clock
+    header = len(TRACE_MAGIC) + 8
+    if len(pending) < header:
+        return None
+    tasks = pending[5]
+    count, = struct.unpack_from('<H', pending, 6)
+    offset = header
+    for _ in range(tasks):
+        if len(pending) < offset + 2:
+            return None
+        offset += 2 + pending[offset + 1]
+    offset += 4 * count + 2
+    if len(pending) < offset:
+        return None
+    return offset
+
+
+def decode_stream(table, stream, out):
+    pending = bytearray()
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            break
+        pending += chunk
+        while pending:
+            if pending[0] == TRACE_MAGIC[0]:
+                length = trace_dump(pending)
+                if length is None:
+                    break
+                if length:
+                    count, = struct.unpack_from('<H', pending, 6)
+                    out.write('<trace dump: %d records>\n' % count)
+                    del pending[:length]
+                    continue
+            if pending[0] != FRAME_START:
+                out.write(chr(pending.pop(0)))
+                continue
+            if len(pending) < 2 or len(pending) < 2 + pending[1]:
+                break
+            payload = bytes(pending[2:2 + pending[1]])
+            try:
+                token, *values = varints(payload)
+                if token not in table:
+                    raise ValueError('unknown token %d' % token)
+                out.write(expand(table[token], values))
+                del pending[:2 + len(payload)]
+            except ValueError as e:
+                # lost sync, drop the start byte and rescan
+                out.write('<log: %s>\n' % e)
+                del pending[0]
+        out.flush()
+
+
+def decode(args):
+    table = load_table(args.table)
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud)
+    elif args.capture:
+        stream = open(args.capture, 'rb', buffering=0)
+    else:
+        stream = sys.stdin.buffer
+    decode_stream(table, stream, sys.stdout)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Tokenized log tools')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    p = sub.add_parser('extract', help='write the token table of an ELF image')
+    p.add_argument('elf')
+    p.add_argument('-o', '--output')
+    p.set_defaults(func=extract)
+
+    p = sub.add_parser('decode', help='decode a captured byte stream')
+    p.add_argument('table')
+    p.add_argument('capture', nargs='?', help='capture file (default stdin)')
+    p.add_argument('--port', help='read live from a serial port (needs pyserial)')
+    p.add_argument('--baud', type=int, default=115200)
+    p.set_defaults(func=decode)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
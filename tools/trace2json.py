@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+# Kernel trace dump to Chrome trace JSON converter
+# Rolando Rosales
+#
+# Finds every trace dump (see trace.h) in a captured UART byte stream and
+# writes a timeline that chrome://tracing or ui.perfetto.dev can open.
+# Task slices come from TRACE_SWITCH records, ISRs are drawn as nested
+# slices on their own row, and everything else is an instant event.
+#
+# Usage:
+#   trace2json.py capture.bin -o trace.json
+#   trace2json.py --port /dev/ttyACM0 -o trace.json   (then type "trace")
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = b'\x01TRC'
+VERSION = 1
+
+ELAPSED, SWITCH, SVC, SEM_WAIT, SEM_BLOCK, SEM_POST, MTX_LOCK, MTX_BLOCK, \
+    MTX_UNLOCK, ISR_ENTER, ISR_EXIT, READY, FAULT, FLG_SET, FLG_BLOCK = range(15)
+
+INSTANTS = {
+    SVC: ('svc', 'svc'),
+    SEM_WAIT: ('wait', 'semaphore'),
+    SEM_BLOCK: ('wait (blocked)', 'semaphore'),
+    SEM_POST: ('post', 'semaphore'),
+    MTX_LOCK: ('lock', 'mutex'),
+    MTX_BLOCK: ('lock (blocked)', 'mutex'),
+    MTX_UNLOCK: ('unlock', 'mutex'),
+    READY: ('ready', 'task'),
+    FAULT: ('fault', 'exception'),
+    FLG_SET: ('set flags', 'group'),
+    FLG_BLOCK: ('wait flags (blocked)', 'group'),
+}
+
+ISR_TID = 1000
+
+
+class Reader:
+    def __init__(self, data, offset):
+        self.data = data
+        self.offset = offset
+        self.sum = 0
+
+    def take(self, fmt):
+        size = struct.calcsize(fmt)
+        chunk = self.data[self.offset:self.offset + size]
+        if len(chunk) < size:
+            raise ValueError('truncated dump')
+        self.offset += size
+        self.sum = (self.sum + sum(chunk)) & 0xFFFF
+        return struct.unpack('<' + fmt, chunk)
+
+    def bytes(self, size):
+        chunk = self.data[self.offset:self.offset + size]
+        if len(chunk) < size:
+            raise ValueError('truncated dump')
+        self.offset += size
+        self.sum = (self.sum + sum(chunk)) & 0xFFFF
+        return chunk
+
+
+def parse_dump(data, offset):
+    r = Reader(data, offset + len(MAGIC))
+    version, tasks, count, hz = r.take('BBHI')
+    if version != VERSION:
+        raise ValueError('unsupported dump version %d' % version)
+    names = {}
+    for _ in range(tasks):
+        index, length = r.take('BB')
+        names[index] = r.bytes(length).decode('latin-1')
+    records = r.take('%dI' % count) if count else ()
+    expected = r.sum
+    checksum, = Reader(data, r.offset).take('H')
+    if checksum != expected:
+        raise ValueError('bad checksum')
+    return {'hz': hz, 'names': names, 'records': records}, r.offset + 2
+
+
+def to_events(dump, pid):
+    us_per_cycle = 1e6 / dump['hz']
+    names = dump['names']
+    events = [{'ph': 'M', 'pid': pid, 'name': 'process_name',
+               'args': {'name': 'RTOS dump %d' % pid}},
+              {'ph': 'M', 'pid': pid, 'tid': ISR_TID, 'name': 'thread_name',
+               'args': {'name': 'ISR'}}]
+    for index, name in names.items():
+        events.append({'ph': 'M', 'pid': pid, 'tid': index, 'name': 'thread_name',
+                       'args': {'name': name}})
+
+    cycles = 0
+    high = 0
+    running = None
+    for record in dump['records']:
+        kind = record >> 28
+        arg = (record >> 20) & 0xFF
+        delta = record & 0xFFFFF
+        if kind == ELAPSED:
+            high = delta << 20
+            continue
+        cycles += high | delta
+        high = 0
+        ts = cycles * us_per_cycle
+
+        if kind == SWITCH:
+            if running is not None:
+                events.append({'ph': 'E', 'pid': pid, 'tid': running, 'ts': ts})
+            running = arg
+            events.append({'ph': 'B', 'pid': pid, 'tid': arg, 'ts': ts,
+                           'name': names.get(arg, 'task %d' % arg)})
+        elif kind in (ISR_ENTER, ISR_EXIT):
+            events.append({'ph': 'B' if kind == ISR_ENTER else 'E', 'pid': pid,
+                           'tid': ISR_TID, 'ts': ts, 'name': 'exception %d' % arg})
+        elif kind in INSTANTS:
+            label, key = INSTANTS[kind]
+            value = names.get(arg, arg) if key == 'task' else arg
+            events.append({'ph': 'i', 's': 't', 'pid': pid,
+                           'tid': running if running is not None else ISR_TID,
+                           'ts': ts, 'name': '%s %s' % (label, value), 'args': {key: value}})
+    if running is not None:
+        events.append({'ph': 'E', 'pid': pid, 'tid': running, 'ts': cycles * us_per_cycle})
+    return events
+
+
+def convert(data):
+    events = []
+    offset = data.find(MAGIC)
+    dumps = 0
+    while offset >= 0:
+        try:
+            dump, end = parse_dump(data, offset)
+        except (ValueError, struct.error) as e:
+            sys.stderr.write('skipping dump at byte %d: %s\n' % (offset, e))
+            end = offset + 1
+        else:
+            dumps += 1
+            events += to_events(dump, dumps)
+        offset = data.find(MAGIC, end)
+    if not dumps:
+        sys.exit('no trace dump found')
+    return {'traceEvents': events, 'displayTimeUnit': 'ns'}
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert kernel trace dumps to Chrome trace JSON')
+    parser.add_argument('capture', nargs='?', help='capture file (default stdin)')
+    parser.add_argument('-o', '--output')
+    parser.add_argument('--port', help='read live from a serial port until idle (needs pyserial)')
+    parser.add_argument('--baud', type=int, default=115200)
+    args = parser.parse_args()
+
+    if args.port:
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=2) as port:
+            data = b''
+            while True:
+                chunk = port.read(4096)
+                if not chunk and MAGIC in data:
+                    break
+                data += chunk
+    elif args.capture:
+        with open(args.capture, 'rb') as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    out = open(args.output, 'w') if args.output else sys.stdout
+    json.dump(convert(data), out)
+    if out is not sys.stdout:
+        out.close()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,191 @@
+// Kernel event trace functions
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "uart0.h"
+#include "spctl.h"
+#include "kernel.h"
+#include "board.h"
+#include "trace.h"
+
+#if TRACE_TASKS != MAX_TASKS
+#error "TRACE_TASKS must match MAX_TASKS"
+#endif
+
+uint32_t traceRing[TRACE_ENTRIES];
+uint32_t traceHead = 0;           // total records written, wraps the ring
+uint32_t traceLast = 0;           // CYCCNT at the last record
+bool traceEnabled = false;
+const char *traceNames[MAX_TASKS];
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Starts the cycle counter and begins recording
+void initTrace(void)
+{
+    NVIC_DBG_INT_R |= NVIC_DBG_INT_TRCENA;
+    DWT_CYCCNT_R = 0;
+    DWT_CTRL_R |= DWT_CTRL_CYCCNTENA;
+
+    traceHead = 0;
+    traceLast = 0;
+    traceEnabled = true;
+}
+
+// Remembers the task name so the dump can label the timeline
+void traceName(uint8_t task, const char name[])
+{
+    if (task < MAX_TASKS)
+        traceNames[task] = name;
+}
+
+static void tracePut(uint32_t record)
+{
+    traceRing[traceHead & (TRACE_ENTRIES - 1)] = record;
+    traceHead++;
+}
+
+// Records an event, called from handler mode only
+void traceEvent(uint8_t type, uint8_t arg)
+{
+    uint32_t primask;
+    uint32_t now;
+    uint32_t delta;
+
+    if (!traceEnabled)
+        return;
+
+    primask = enterCritical();
+    now = DWT_CYCCNT_R;
+    delta = now - traceLast;
+    traceLast = now;
+
+    // gaps longer than 2^20 cycles (26 ms) need an extra record
+    if (delta > TRACE_DELTA_M)
+        tracePut(((uint32_t)TRACE_ELAPSED << TRACE_TYPE_S) | ((delta >> 20) & TRACE_DELTA_M));
+
+    tracePut(((uint32_t)type << TRACE_TYPE_S) | ((uint32_t)arg << TRACE_ARG_S) | (delta & TRACE_DELTA_M));
+    leaveCritical(primask);
+}
+
+static uint16_t tracePutc(uint16_t sum, uint8_t c)
+{
+    putcUart0(c);
+    return sum + c;
+}
+
+static uint16_t tracePutWord(uint16_t sum, uint32_t word, uint8_t bytes)
+{
+    while (bytes--)
+    {
+        sum = tracePutc(sum, word & 0xFF);
+        word >>= 8;
+    }
+    return sum;
+}
+
+// Writes a ring that head records went through to UART0 in the binary dump
+// format (see trace.h), names[task] labels each task (0 if there is none)
+static void traceSend(uint32_t head, const uint32_t ring[], const char *const names[])
+{
+    uint32_t first;
+    uint16_t count;
+    uint16_t sum = 0;
+    uint8_t tasks = 0;
+    uint8_t task;
+    uint8_t len;
+
+    first = head > TRACE_ENTRIES ? head - TRACE_ENTRIES : 0;
+    count = head - first;
+    for (task = 0; task < MAX_TASKS; task++)
+        if (names[task])
+            tasks++;
+
+    putsUart0(TRACE_MAGIC);
+    sum = tracePutc(sum, TRACE_VERSION);
+    sum = tracePutc(sum, tasks);
+    sum = tracePutWord(sum, count, 2);
+    sum = tracePutWord(sum, BOARD_CLOCK_HZ, 4);
+
+    for (task = 0; task < MAX_TASKS; task++)
+    {
+        if (names[task])
+        {
+            len = 0;
+            while (names[task][len] != '\0')
+                len++;
+            sum = tracePutc(sum, task);
+            sum = tracePutc(sum, len);
+            for (len = 0; names[task][len] != '\0'; len++)
+                sum = tracePutc(sum, names[task][len]);
+        }
+    }
+
+    for (; first != head; first++)
+        sum = tracePutWord(sum, ring[first & (TRACE_ENTRIES - 1)], 4);
+
+    tracePutWord(0, sum, 2);
+}
+
+// Writes the ring straight from kernel RAM, for the fault handlers, which
+// cannot leave the work to a task
+// Recording is paused while the dump is sent so it does not trace itself
+void traceDump(void)
+{
+    bool enabled = traceEnabled;
+
+    traceEnabled = false;
+    traceSend(traceHead, traceRing, traceNames);
+    traceEnabled = enabled;
+}
+
+// Copies the ring and the task names for a task to write out with
+// traceWrite, in handler mode
+void traceCopy(TRACE_DATA *trace)
+{
+    uint32_t primask;
+    uint8_t task;
+    uint8_t i;
+
+    primask = enterCritical();
+    trace->head = traceHead;
+    for (i = 0; i < TRACE_ENTRIES; i++)
+        trace->ring[i] = traceRing[i];
+    leaveCritical(primask);
+
+    for (task = 0; task < MAX_TASKS; task++)
+    {
+        i = 0;
+        if (traceNames[task])
+            for (; i < sizeof(trace->name[0]) - 1 && traceNames[task][i] != '\0'; i++)
+                trace->name[task][i] = traceNames[task][i];
+        trace->name[task][i] = '\0';
+    }
+}
+
+// Writes a copy from traceCopy to UART0, in thread mode, so the kernel and
+// the interrupts keep running while the bytes go out
+void traceWrite(const TRACE_DATA *trace)
+{
+    const char *names[MAX_TASKS];
+    uint8_t task;
+
+    for (task = 0; task < MAX_TASKS; task++)
+        names[task] = trace->name[task][0] != '\0' ? trace->name[task] : 0;
+    traceSend(trace->head, trace->ring, names);
+}
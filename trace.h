@@ -0,0 +1,88 @@
+// Kernel event trace functions
+// Rolando Rosales
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// data watchpoint and trace unit (not in tm4c123gh6pm.h)
+#define DWT_CTRL_R              (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT_R            (*((volatile uint32_t *)0xE0001004))
+#define DWT_CTRL_CYCCNTENA      0x00000001
+#define NVIC_DBG_INT_TRCENA     0x01000000  // enables the DWT and ITM
+
+// ring size in records, must be a power of two
+#define TRACE_ENTRIES 128
+
+// record = type (4 bits) | arg (8 bits) | cycles since last record (20 bits)
+#define TRACE_TYPE_S   28
+#define TRACE_ARG_S    20
+#define TRACE_DELTA_M  0x000FFFFF
+
+// event types
+#define TRACE_ELAPSED    0  // delta holds the upper bits of the next delta
+#define TRACE_SWITCH     1  // arg = task switched in
+#define TRACE_SVC        2  // arg = svc number
+#define TRACE_SEM_WAIT   3  // arg = semaphore taken
+#define TRACE_SEM_BLOCK  4  // arg = semaphore the task now waits on
+#define TRACE_SEM_POST   5  // arg = semaphore
+#define TRACE_MTX_LOCK   6  // arg = mutex taken
+#define TRACE_MTX_BLOCK  7  // arg = mutex the task now waits on
+#define TRACE_MTX_UNLOCK 8  // arg = mutex
+#define TRACE_ISR_ENTER  9  // arg = exception number
+#define TRACE_ISR_EXIT   10 // arg = exception number
+#define TRACE_READY      11 // arg = task made ready
+#define TRACE_FAULT      12 // arg = exception number
+#define TRACE_FLG_SET    13 // arg = event group
+#define TRACE_FLG_BLOCK  14 // arg = event group the task now waits on
+
+// an interrupt handler outside the kernel brackets its body with these to show
+// up in the trace, the arg is the active exception number (VECACTIVE)
+#define TRACE_ISR_BEGIN() traceEvent(TRACE_ISR_ENTER, NVIC_INT_CTRL_R & NVIC_INT_CTRL_VEC_ACT_M)
+#define TRACE_ISR_END()   traceEvent(TRACE_ISR_EXIT, NVIC_INT_CTRL_R & NVIC_INT_CTRL_VEC_ACT_M)
+
+// dump = magic, version, task count, record count (2), cpu clock (4),
+//        task count * (index, name length, name), records (4 each, oldest first),
+//        16-bit sum of every byte after the magic
+#define TRACE_MAGIC      "\001TRC"
+#define TRACE_VERSION    1
+
+// the dump of the shell's trace command is written by the shell task from a
+// copy (copyTrace, traceWrite), a fault handler writes it directly (traceDump)
+#define TRACE_TASKS      12 // MAX_TASKS, kernel.h includes this file first
+
+typedef struct _TRACE_DATA
+{
+    uint32_t head;                 // records written when it was copied
+    uint32_t ring[TRACE_ENTRIES];
+    char name[TRACE_TASKS][16];    // empty for a record without a task
+} TRACE_DATA;
+
+// dump the ring when a fault handler runs
+#define TRACE_DUMP_ON_FAULT 1
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initTrace(void);
+void traceName(uint8_t task, const char name[]);
+void traceEvent(uint8_t type, uint8_t arg);
+void traceDump(void);
+void traceCopy(TRACE_DATA *trace);
+void traceWrite(const TRACE_DATA *trace);
+
+#endif